@@ -65,8 +65,15 @@ function applyPatch(newHtml, root_id) {
     return;
   }
 
-  const nextBody = parseBody(newHtml);
+  patchChildren(root, parseBody(newHtml));
+}
+
+// The converter's output when it comes with source positions
+function isBodyContainer(node) {
+  return node.nodeType === Node.ELEMENT_NODE && node.hasAttribute('data-preview-body');
+}
 
+function patchChildren(root, nextBody) {
   const oldNodes = Array.from(root.childNodes);
   const newNodes = Array.from(nextBody.childNodes);
 
@@ -81,7 +88,9 @@ function applyPatch(newHtml, root_id) {
     } else if (oldNode && !newNode) {
       root.removeChild(oldNode);
     } else if (oldNode && newNode) {
-      if (!nodesEqual(oldNode, newNode)) {
+      if (isBodyContainer(oldNode) && isBodyContainer(newNode)) {
+        patchChildren(oldNode, newNode);
+      } else if (!nodesEqual(oldNode, newNode)) {
         root.replaceChild(newNode.cloneNode(true), oldNode);
       }
     }
@@ -115,3 +124,40 @@ function nodesEqual(a, b) {
 
   return a.textContent === b.textContent;
 }
+
+// Source positions arrive as a side table of [tag, n, "l:c-l:c"] entries,
+// where n is the element's index among same-named tags in the body container,
+// which holds the converter's output without the document headers.
+// Attributes are attached only when something asks for them.
+// The patcher is injected again after each load; keep a table set during parsing.
+var sourceposTable = window.sourceposTable ?? null;
+
+function setSourcepos(table) {
+  sourceposTable = table;
+}
+
+function attachSourcepos(root_id) {
+  const root = document.getElementById(root_id);
+  const body = root && root.querySelector('[data-preview-body]');
+  if (!body || !sourceposTable) {
+    return;
+  }
+
+  const byTag = new Map();
+  for (const [tag, n, range] of sourceposTable) {
+    if (!byTag.has(tag)) {
+      byTag.set(tag, body.getElementsByTagName(tag));
+    }
+    const el = byTag.get(tag)[n];
+    if (el) {
+      el.setAttribute('data-sourcepos', range);
+    }
+  }
+  sourceposTable = null;
+}
+
+function sourceposOf(el, root_id) {
+  attachSourcepos(root_id);
+  const node = el.closest('[data-sourcepos]');
+  return node ? node.getAttribute('data-sourcepos') : null;
+}
@@ -0,0 +1,574 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "asset_inliner.h"
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <system_error>
+
+#include "preview_config.h"
+#include "util/string_utils.h"
+#include "util/thread_pool.h"
+
+namespace {
+constexpr char kBase64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+// Multiple of 3, so chunks encode without padding in between
+constexpr std::size_t kStreamChunk = 3 * 64 * 1024;
+
+bool isNameChar(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == ':';
+}
+
+bool isSpace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f';
+}
+
+int hexValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  return (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+}
+
+std::string percentDecode(std::string_view s) {
+  std::string out;
+  out.reserve(s.size());
+  for (std::size_t i = 0; i < s.size(); ++i) {
+    int hi = 0, lo = 0;
+    if (s[i] == '%' && i + 2 < s.size() && (hi = hexValue(s[i + 1])) >= 0 &&
+        (lo = hexValue(s[i + 2])) >= 0) {
+      out += static_cast<char>(hi * 16 + lo);
+      i += 2;
+    } else {
+      out += s[i];
+    }
+  }
+  return out;
+}
+
+// Local file a URL refers to, or empty for remote, data: and fragment URLs.
+std::filesystem::path localPath(std::string_view url, const std::filesystem::path &dir) {
+  url = StringUtils::trimWhitespaceView(url);
+  if (url.empty() || url[0] == '#' || url.starts_with("//")) {
+    return {};
+  }
+
+  constexpr std::string_view kFileScheme = "file://";
+  bool absolute = false;
+  if (url.starts_with(kFileScheme)) {
+    url.remove_prefix(kFileScheme.size());
+    absolute = true;
+  } else if (auto colon = url.find(':'); colon != std::string_view::npos &&
+                                         colon < url.find_first_of("/?#")) {
+    return {};  // another scheme
+  }
+
+  url = url.substr(0, url.find_first_of("?#"));
+  std::filesystem::path p =
+      percentDecode(StringUtils::replaceAll(std::string{ url }, "&amp;", "&"));
+  if (p.empty() || (absolute && !p.is_absolute())) {
+    return {};
+  }
+  if (p.is_relative()) {
+    if (dir.empty()) {
+      return {};
+    }
+    p = dir / p;
+  }
+  return p.lexically_normal();
+}
+
+void appendBase64(std::string &out, std::string_view bytes) {
+  const auto *p = reinterpret_cast<const unsigned char *>(bytes.data());
+  std::size_t n = bytes.size();
+  out.reserve(out.size() + (n + 2) / 3 * 4);
+
+  std::size_t i = 0;
+  for (; i + 3 <= n; i += 3) {
+    std::uint32_t v = (p[i] << 16) | (p[i + 1] << 8) | p[i + 2];
+    out += kBase64[v >> 18];
+    out += kBase64[(v >> 12) & 63];
+    out += kBase64[(v >> 6) & 63];
+    out += kBase64[v & 63];
+  }
+  if (i < n) {
+    std::uint32_t v = p[i] << 16;
+    if (i + 1 < n) {
+      v |= p[i + 1] << 8;
+    }
+    out += kBase64[v >> 18];
+    out += kBase64[(v >> 12) & 63];
+    out += i + 1 < n ? kBase64[(v >> 6) & 63] : '=';
+    out += '=';
+  }
+}
+}  // namespace
+
+std::string AssetInliner::base64(std::string_view bytes) {
+  std::string out;
+  appendBase64(out, bytes);
+  return out;
+}
+
+std::string_view AssetInliner::mimeType(const std::filesystem::path &file) {
+  static const std::unordered_map<std::string_view, std::string_view> types = {
+    { ".apng", "image/apng" },
+    { ".avif", "image/avif" },
+    { ".bmp", "image/bmp" },
+    { ".css", "text/css" },
+    { ".gif", "image/gif" },
+    { ".ico", "image/x-icon" },
+    { ".jpeg", "image/jpeg" },
+    { ".jpg", "image/jpeg" },
+    { ".mp3", "audio/mpeg" },
+    { ".mp4", "video/mp4" },
+    { ".oga", "audio/ogg" },
+    { ".ogg", "audio/ogg" },
+    { ".ogv", "video/ogg" },
+    { ".otf", "font/otf" },
+    { ".png", "image/png" },
+    { ".svg", "image/svg+xml" },
+    { ".ttf", "font/ttf" },
+    { ".wav", "audio/wav" },
+    { ".webm", "video/webm" },
+    { ".webp", "image/webp" },
+    { ".woff", "font/woff" },
+    { ".woff2", "font/woff2" },
+  };
+  std::string ext = StringUtils::toLower(file.extension().string());
+  auto it = types.find(ext);
+  return it != types.end() ? it->second : std::string_view{};
+}
+
+std::filesystem::path AssetInliner::rootFor(const std::filesystem::path &dir) {
+  if (PreviewConfig::instance().get(Settings::kExportInlineOutsideFolder)) {
+    return {};
+  }
+  std::error_code ec;
+  auto root = std::filesystem::weakly_canonical(dir, ec);
+  return ec ? dir.lexically_normal() : root;
+}
+
+bool AssetInliner::isWithin(
+    const std::filesystem::path &file,
+    const std::filesystem::path &root
+) {
+  if (root.empty()) {
+    return true;
+  }
+  // Resolved, so neither ".." nor a symlink leads out of root
+  std::error_code ec;
+  auto resolved = std::filesystem::weakly_canonical(file, ec);
+  if (ec) {
+    return false;
+  }
+  auto r = root.begin();
+  for (auto f = resolved.begin(); r != root.end() && f != resolved.end(); ++r, ++f) {
+    if (r->empty()) {
+      break;  // trailing separator
+    }
+    if (*r != *f) {
+      return false;
+    }
+  }
+  return r == root.end() || r->empty();
+}
+
+AssetInliner::FileStamp AssetInliner::FileStamp::of(const std::filesystem::path &file) {
+  FileStamp stamp;
+  stamp.file = file;
+  std::error_code ec;
+  auto size = std::filesystem::file_size(file, ec);
+  auto mtime = std::filesystem::last_write_time(file, ec);
+  if (!ec) {
+    stamp.size = size;
+    stamp.mtime = mtime;
+  }
+  return stamp;
+}
+
+bool AssetInliner::FileStamp::current() const {
+  auto now = of(file);
+  return now.size == size && now.mtime == mtime;
+}
+
+void AssetInliner::findHtmlRefs(
+    std::string_view html,
+    const std::filesystem::path &dir,
+    std::vector<Ref> &refs
+) {
+  auto add = [&](std::size_t begin, std::size_t end) {
+    auto file = localPath(html.substr(begin, end - begin), dir);
+    if (!file.empty()) {
+      refs.push_back({ begin, end, std::move(file) });
+    }
+  };
+
+  // "url 2x, url 480w" -> each url
+  auto addSrcset = [&](std::size_t begin, std::size_t end) {
+    std::size_t i = begin;
+    while (i < end) {
+      while (i < end && (isSpace(html[i]) || html[i] == ',')) {
+        ++i;
+      }
+      std::size_t url_end = i;
+      while (url_end < end && !isSpace(html[url_end])) {
+        ++url_end;
+      }
+      // A trailing comma belongs to the list, not the URL
+      std::size_t stop = url_end;
+      if (stop > i && html[stop - 1] == ',') {
+        --stop;
+      }
+      if (stop > i) {
+        add(i, stop);
+      }
+      i = url_end;
+      while (i < end && html[i] != ',') {
+        ++i;
+      }
+    }
+  };
+
+  std::size_t pos = 0;
+  while ((pos = html.find('<', pos)) != std::string_view::npos) {
+    if (html.substr(pos, 4) == "<!--") {
+      pos = html.find("-->", pos + 4);
+      if (pos == std::string_view::npos) {
+        break;
+      }
+      pos += 3;
+      continue;
+    }
+
+    std::size_t i = pos + 1;
+    while (i < html.size() && isNameChar(html[i])) {
+      ++i;
+    }
+    std::string tag = StringUtils::toLower(html.substr(pos + 1, i - pos - 1));
+    if (tag.empty()) {
+      pos = i;
+      continue;
+    }
+
+    struct Attr {
+      std::string name;
+      std::size_t begin, end;
+    };
+    std::vector<Attr> attrs;
+    while (i < html.size() && html[i] != '>') {
+      if (isSpace(html[i]) || html[i] == '/') {
+        ++i;
+        continue;
+      }
+      std::size_t name_begin = i;
+      while (i < html.size() && !isSpace(html[i]) && html[i] != '=' && html[i] != '>') {
+        ++i;
+      }
+      std::string name = StringUtils::toLower(html.substr(name_begin, i - name_begin));
+      while (i < html.size() && isSpace(html[i])) {
+        ++i;
+      }
+      if (i >= html.size() || html[i] != '=') {
+        continue;
+      }
+      ++i;
+      while (i < html.size() && isSpace(html[i])) {
+        ++i;
+      }
+      std::size_t begin = i, end = i;
+      if (i < html.size() && (html[i] == '"' || html[i] == '\'')) {
+        begin = i + 1;
+        end = html.find(html[i], begin);
+        end = end == std::string_view::npos ? html.size() : end;
+        i = std::min(end + 1, html.size());
+      } else {
+        while (i < html.size() && !isSpace(html[i]) && html[i] != '>') {
+          ++i;
+        }
+        end = i;
+      }
+      attrs.push_back({ std::move(name), begin, end });
+    }
+    pos = std::min(i + 1, html.size());
+
+    auto attrValue = [&](std::string_view name) -> std::string {
+      for (const auto &a : attrs) {
+        if (a.name == name) {
+          return StringUtils::toLower(html.substr(a.begin, a.end - a.begin));
+        }
+      }
+      return {};
+    };
+
+    for (const auto &a : attrs) {
+      if (a.name == "src" || a.name == "poster") {
+        add(a.begin, a.end);
+      } else if (a.name == "srcset") {
+        addSrcset(a.begin, a.end);
+      } else if (a.name == "href" && tag == "link") {
+        std::string rel = attrValue("rel");
+        if (rel.find("stylesheet") != std::string::npos ||
+            rel.find("icon") != std::string::npos) {
+          add(a.begin, a.end);
+        }
+      } else if (a.name == "style") {
+        findCssRefs(html.substr(a.begin, a.end - a.begin), a.begin, dir, refs);
+      }
+    }
+
+    // Raw text: scan style sheets for url(), leave scripts alone
+    if (tag == "style" || tag == "script") {
+      std::size_t end = html.find("</" + tag, pos);
+      end = end == std::string_view::npos ? html.size() : end;
+      if (tag == "style") {
+        findCssRefs(html.substr(pos, end - pos), pos, dir, refs);
+      }
+      pos = end;
+    }
+  }
+}
+
+void AssetInliner::findCssRefs(
+    std::string_view css,
+    std::size_t offset,
+    const std::filesystem::path &dir,
+    std::vector<Ref> &refs
+) {
+  std::size_t pos = 0;
+  while ((pos = css.find("url(", pos)) != std::string_view::npos) {
+    std::size_t i = pos + 4;
+    while (i < css.size() && isSpace(css[i])) {
+      ++i;
+    }
+    std::size_t begin = i, end;
+    if (i < css.size() && (css[i] == '"' || css[i] == '\'')) {
+      begin = i + 1;
+      end = css.find(css[i], begin);
+    } else {
+      end = css.find(')', begin);
+      while (end != std::string_view::npos && end > begin && isSpace(css[end - 1])) {
+        --end;
+      }
+    }
+    if (end == std::string_view::npos) {
+      break;
+    }
+
+    auto file = localPath(css.substr(begin, end - begin), dir);
+    if (!file.empty()) {
+      refs.push_back({ offset + begin, offset + end, std::move(file) });
+    }
+    pos = end;
+  }
+}
+
+void AssetInliner::inlineHtml(
+    std::string_view html,
+    const std::filesystem::path &dir,
+    Output &out
+) {
+  std::vector<Ref> refs;
+  findHtmlRefs(html, dir, refs);
+  std::sort(refs.begin(), refs.end(), [](const Ref &a, const Ref &b) {
+    return a.begin < b.begin;
+  });
+  emit(html, refs, out, rootFor(dir), false);
+}
+
+void AssetInliner::inlineCss(
+    std::string_view css,
+    const std::filesystem::path &dir,
+    Output &out
+) {
+  std::vector<Ref> refs;
+  findCssRefs(css, 0, dir, refs);
+  emit(css, refs, out, rootFor(dir), false);
+}
+
+void AssetInliner::emit(
+    std::string_view text,
+    const std::vector<Ref> &refs,
+    Output &out,
+    const std::filesystem::path &root,
+    bool nested
+) {
+  // Each distinct file is loaded once, all of them in parallel
+  std::map<std::filesystem::path, std::size_t> index;
+  std::vector<const std::filesystem::path *> files;
+  for (const auto &r : refs) {
+    if (index.emplace(r.file, files.size()).second) {
+      files.push_back(&r.file);
+    }
+  }
+
+  std::vector<Asset> assets(files.size());
+  ThreadPool::instance().parallelFor(files.size(), [&](std::size_t i) {
+    assets[i] = load(*files[i], root, nested);
+  });
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    out.files_.push_back(*files[i]);
+    out.files_.insert(out.files_.end(), assets[i].deps.begin(), assets[i].deps.end());
+  }
+
+  std::size_t pos = 0;
+  for (const auto &r : refs) {
+    if (r.begin < pos) {
+      continue;  // overlapping match, e.g. url() inside a src value
+    }
+    const Asset &asset = assets[index[r.file]];
+    if (!asset.uri && asset.stream.empty()) {
+      continue;
+    }
+
+    out.text(text.substr(pos, r.begin - pos));
+    if (asset.uri) {
+      out.assets_.push_back(asset.uri);
+      out.pieces_.push_back({ *asset.uri, {}, {} });
+    } else {
+      out.pieces_.push_back({ {}, asset.stream, asset.mime });
+    }
+    pos = r.end;
+  }
+  out.text(text.substr(pos));
+}
+
+AssetInliner::Asset AssetInliner::load(
+    const std::filesystem::path &file,
+    const std::filesystem::path &root,
+    bool nested
+) {
+  Asset asset;
+  asset.mime = mimeType(file);
+  if (asset.mime.empty() || !isWithin(file, root)) {
+    return {};
+  }
+
+  std::error_code ec;
+  if (!std::filesystem::is_regular_file(file, ec)) {
+    return {};
+  }
+  auto size = std::filesystem::file_size(file, ec);
+  auto mtime = std::filesystem::last_write_time(file, ec);
+  if (ec) {
+    return {};
+  }
+  bool css = asset.mime == "text/css";
+  if (size > kStreamSize && !css && !nested) {
+    asset.stream = file;
+    return asset;
+  }
+
+  // A rewritten stylesheet is only as fresh as the files it embeds
+  const bool rewrite = css && !nested;
+  const std::string key = file.string();
+  std::vector<FileStamp> cached_deps;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto *gen : { &current_, &previous_ }) {
+      auto it = gen->find(key);
+      if (it != gen->end() && it->second.mtime == mtime && it->second.size == size &&
+          (!rewrite || it->second.root == root)) {
+        asset.uri = it->second.uri;
+        cached_deps = it->second.deps;
+        break;
+      }
+    }
+  }
+  if (asset.uri && !std::all_of(cached_deps.begin(), cached_deps.end(), [](const auto &d) {
+        return d.current();
+      })) {
+    asset.uri.reset();
+  }
+
+  std::vector<FileStamp> deps = std::move(cached_deps);
+  if (!asset.uri) {
+    std::ifstream in(file, std::ios::binary);
+    std::string bytes(size, '\0');
+    if (!in.read(bytes.data(), static_cast<std::streamsize>(size))) {
+      return {};
+    }
+
+    // Fonts and images of a stylesheet are relative to the stylesheet.
+    // Their own stylesheets are not followed, which also stops @import loops.
+    if (rewrite) {
+      Output rewritten;
+      std::vector<Ref> refs;
+      findCssRefs(bytes, 0, file.parent_path(), refs);
+      // Stamped before they are read, so a change in between is seen next time
+      deps.clear();
+      for (const auto &r : refs) {
+        deps.push_back(FileStamp::of(r.file));
+      }
+      emit(bytes, refs, rewritten, root, true);
+      std::ostringstream flat;
+      rewritten.write(flat);
+      bytes = std::move(flat).str();
+    }
+
+    std::string uri = "data:" + std::string{ asset.mime } + ";base64,";
+    appendBase64(uri, bytes);
+    asset.uri = std::make_shared<const std::string>(std::move(uri));
+  }
+  for (const auto &d : deps) {
+    asset.deps.push_back(d.file);
+  }
+
+  // Store, replace a stale entry or promote to the current generation
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = current_.find(key);
+  if (it != current_.end() && it->second.uri == asset.uri) {
+    return asset;
+  }
+  if (it != current_.end()) {
+    current_bytes_ -= it->second.uri->size();
+    current_.erase(it);
+  }
+  if (current_bytes_ + asset.uri->size() > kCacheMaxBytes) {
+    previous_ = std::move(current_);
+    current_.clear();
+    current_bytes_ = 0;
+  }
+  current_[key] = { mtime, size, asset.uri, rewrite ? root : std::filesystem::path{},
+                    std::move(deps) };
+  current_bytes_ += asset.uri->size();
+  return asset;
+}
+
+void AssetInliner::clearCache() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  current_.clear();
+  previous_.clear();
+  current_bytes_ = 0;
+}
+
+bool AssetInliner::Output::write(std::ostream &out) const {
+  std::string encoded;
+  std::vector<char> buf(kStreamChunk);
+
+  for (const auto &piece : pieces_) {
+    if (piece.file.empty()) {
+      out.write(piece.text.data(), static_cast<std::streamsize>(piece.text.size()));
+      continue;
+    }
+
+    out << "data:" << piece.mime << ";base64,";
+    std::ifstream in(piece.file, std::ios::binary);
+    while (in && out) {
+      in.read(buf.data(), static_cast<std::streamsize>(buf.size()));
+      encoded.clear();
+      appendBase64(encoded, { buf.data(), static_cast<std::size_t>(in.gcount()) });
+      out.write(encoded.data(), static_cast<std::streamsize>(encoded.size()));
+    }
+    if (!in.eof()) {
+      return false;
+    }
+  }
+  return out.good();
+}
@@ -0,0 +1,159 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Rewrites references to local files in exported HTML and CSS (images,
+// srcset candidates, stylesheets, fonts) to data: URIs, so the page still
+// works after it is moved.  Only files of the types in mimeType() are
+// inlined, and unless export_inline_outside_folder is set, only those in the
+// folder references are resolved against or below it.  Other references are
+// left as they are.
+//
+// Encoded assets are cached by path, mtime and size, and stylesheets also by
+// those of the files they embed, so exporting the same documents again
+// re-encodes nothing.  Assets larger than kStreamSize are never held in
+// memory: they are encoded straight into the output when it is written.
+class AssetInliner {
+ public:
+  static AssetInliner &instance() {
+    static AssetInliner inst;
+    return inst;
+  }
+
+ private:
+  AssetInliner() = default;
+  ~AssetInliner() = default;
+
+  AssetInliner(const AssetInliner &) = delete;
+  AssetInliner &operator=(const AssetInliner &) = delete;
+  AssetInliner(AssetInliner &&) = delete;
+  AssetInliner &operator=(AssetInliner &&) = delete;
+
+ public:
+  // Rewritten text as a sequence of pieces.  Text views point into the
+  // source text or into encoded assets kept alive by the Output.
+  class Output {
+   public:
+    void text(std::string_view text) {
+      if (!text.empty()) {
+        pieces_.push_back({ text, {}, {} });
+      }
+    }
+
+    // Writes the pieces, encoding streamed files on the way.
+    bool write(std::ostream &out) const;
+
+    // Local files referenced, inlined or not, and those embedded by inlined
+    // stylesheets; a page made from the same text is current while they are.
+    const std::vector<std::filesystem::path> &files() const {
+      return files_;
+    }
+
+   private:
+    friend class AssetInliner;
+
+    struct Piece {
+      std::string_view text;
+      std::filesystem::path file;  // streamed as a data: URI if set
+      std::string_view mime;
+    };
+
+    std::vector<Piece> pieces_;
+    std::vector<std::shared_ptr<const std::string>> assets_;
+    std::vector<std::filesystem::path> files_;
+  };
+
+  // Relative references are resolved against dir.  Distinct assets are loaded
+  // and encoded in parallel on the worker pool.  Worker threads too.
+  void inlineHtml(std::string_view html, const std::filesystem::path &dir, Output &out);
+  void inlineCss(std::string_view css, const std::filesystem::path &dir, Output &out);
+
+  void clearCache();
+
+  static std::string base64(std::string_view bytes);
+
+ private:
+  static constexpr std::size_t kStreamSize = 4 * 1024 * 1024;
+
+  // Two generations, as in CodeHighlighter
+  static constexpr std::size_t kCacheMaxBytes = 64 * 1024 * 1024;
+
+  struct Ref {
+    std::size_t begin = 0;  // range of the URL in the text
+    std::size_t end = 0;
+    std::filesystem::path file;
+  };
+
+  struct Asset {
+    std::shared_ptr<const std::string> uri;  // data: URI, or
+    std::filesystem::path stream;            // too large to hold
+    std::string_view mime;
+    std::vector<std::filesystem::path> deps;  // files a stylesheet embeds
+  };
+
+  // A file as it was when it was read; size is kMissing if it wasn't there
+  struct FileStamp {
+    static constexpr std::uintmax_t kMissing = ~std::uintmax_t{ 0 };
+
+    std::filesystem::path file;
+    std::filesystem::file_time_type mtime{};
+    std::uintmax_t size = kMissing;
+
+    static FileStamp of(const std::filesystem::path &file);
+    bool current() const;
+  };
+
+  struct CacheEntry {
+    std::filesystem::file_time_type mtime;
+    std::uintmax_t size = 0;
+    std::shared_ptr<const std::string> uri;
+    // Stylesheets: the folder they were limited to and the files they embed
+    std::filesystem::path root;
+    std::vector<FileStamp> deps;
+  };
+
+  static void findHtmlRefs(
+      std::string_view html,
+      const std::filesystem::path &dir,
+      std::vector<Ref> &refs
+  );
+  static void findCssRefs(
+      std::string_view css,
+      std::size_t offset,
+      const std::filesystem::path &dir,
+      std::vector<Ref> &refs
+  );
+  // Empty for types that are not inlined
+  static std::string_view mimeType(const std::filesystem::path &file);
+  // Folder inlined files must be in, with symlinks resolved; empty if any
+  static std::filesystem::path rootFor(const std::filesystem::path &dir);
+  static bool isWithin(const std::filesystem::path &file, const std::filesystem::path &root);
+
+  // Emits text with refs replaced by their assets; unreadable ones and those
+  // outside root stay as is.
+  void emit(
+      std::string_view text,
+      const std::vector<Ref> &refs,
+      Output &out,
+      const std::filesystem::path &root,
+      bool nested
+  );
+  Asset load(const std::filesystem::path &file, const std::filesystem::path &root, bool nested);
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, CacheEntry> current_;
+  std::unordered_map<std::string, CacheEntry> previous_;
+  std::size_t current_bytes_ = 0;
+};
@@ -0,0 +1,337 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "auto_export.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <glib.h>
+#include <msgwindow.h>
+
+#include "block_hashes.h"
+#include "converter_registrar.h"
+#include "document_geany.h"
+#include "export_html.h"
+#include "preview_config.h"
+#include "preview_pane.h"
+#include "util/main_thread.h"
+#include "util/thread_pool.h"
+#include "util/xdg_utils.h"
+
+namespace {
+template <typename T>
+void appendValue(std::string &out, const T &value) {
+  if constexpr (std::is_same_v<T, std::string>) {
+    out += value;
+  } else if constexpr (std::is_same_v<T, std::vector<int>> ||
+                       std::is_same_v<T, std::vector<std::string>>) {
+    for (const auto &item : value) {
+      appendValue(out, item);
+      out += ',';
+    }
+  } else {
+    out += std::to_string(value);
+  }
+}
+
+// Settings that change the exported page; a key, or a prefix ending in '*'
+constexpr std::string_view kOutputSettings[] = {
+  "code_highlight",        "converter/*",            "export_inline_outside_folder",
+  "export_self_contained", "headers_incomplete_max", "markdown_*",
+  "sniff_txt_files",       "theme_mode",
+};
+
+// Sizes and mtimes of the files a page refers to; missing files count too
+std::uint64_t assetsHash(const std::vector<std::string> &files) {
+  std::string text;
+  for (const auto &file : files) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(file, ec);
+    auto mtime = std::filesystem::last_write_time(file, ec);
+    text += file;
+    if (!ec) {
+      text += '\t' + std::to_string(size) + '\t' +
+              std::to_string(mtime.time_since_epoch().count());
+    }
+    text += '\n';
+  }
+  return BlockHashes::hashBytes(text);
+}
+
+bool affectsOutput(std::string_view key) {
+  return std::any_of(std::begin(kOutputSettings), std::end(kOutputSettings), [&](auto pattern) {
+    if (pattern.ends_with('*')) {
+      return key.starts_with(pattern.substr(0, pattern.size() - 1));
+    }
+    return key == pattern;
+  });
+}
+}  // namespace
+
+void AutoExport::documentSaved(const DocumentGeany &document) {
+  std::filesystem::path source = document.filePath();
+  std::filesystem::path dir = outputDir(source);
+  if (dir.empty()) {
+    return;
+  }
+
+  ConverterRegistrar registrar;
+  std::string_view key = registrar.getConverterKey(document);
+  if (key.empty()) {
+    return;
+  }
+
+  std::filesystem::path dest = dir / outputName(source, registrar);
+  std::error_code ec;
+  if (std::filesystem::equivalent(source, dest, ec)) {
+    return;
+  }
+
+  auto &cfg = PreviewConfig::instance();
+  Request request;
+  request.key = key;
+  request.theme = cfg.get(Settings::kThemeMode);
+  request.dest = std::move(dest);
+  if (cfg.get(Settings::kExportSelfContained)) {
+    request.asset_dir = source.parent_path();
+  }
+  request.text_hash = document.computeHash();
+  request.options_hash = optionsHash(key, request.theme);
+  request.snapshot = document.snapshot();
+
+  auto it = running_.find(request.dest.string());
+  if (it != running_.end()) {
+    it->second = std::move(request);  // replaces an older waiting save
+    return;
+  }
+  start(std::move(request));
+}
+
+std::filesystem::path AutoExport::outputDir(const std::filesystem::path &source) {
+  auto setting = PreviewConfig::instance().get(Settings::kAutoExportDir);
+  if (setting.empty() || source.empty()) {
+    return {};
+  }
+
+  std::filesystem::path dir = XdgUtils::expandEnvVars(setting);
+  if (dir.is_relative()) {
+    dir = source.parent_path() / dir;
+  }
+  return dir.lexically_normal();
+}
+
+std::string AutoExport::outputName(
+    const std::filesystem::path &source,
+    const ConverterRegistrar &registrar
+) {
+  namespace fs = std::filesystem;
+  const fs::path dir = source.parent_path();
+  std::error_code ec;
+  auto mtime = fs::last_write_time(dir, ec);
+
+  // Rescanned only when files are added, removed or renamed
+  auto &shared = shared_stems_[dir.string()];
+  if (ec || shared.mtime != mtime) {
+    std::unordered_map<std::string, int> uses;
+    auto opts = fs::directory_options::skip_permission_denied;
+    for (fs::directory_iterator it(dir, opts, ec), end; !ec && it != end; it.increment(ec)) {
+      std::string ext = it->path().extension().string();
+      std::string_view key = ext.size() > 1 ? registrar.getConverterKey(ext.substr(1)) : "";
+      if (!key.empty() && key != "html") {  // pages exported next to their sources
+        ++uses[it->path().stem().string()];
+      }
+    }
+    shared.mtime = mtime;
+    shared.stems.clear();
+    for (const auto &[stem, n] : uses) {
+      if (n > 1) {
+        shared.stems.insert(stem);
+      }
+    }
+  }
+
+  // As in batch export: notes.md and notes.rst -> notes.md.html, notes.rst.html
+  std::string stem = source.stem().string();
+  return (shared.stems.contains(stem) ? source.filename().string() : stem) + ".html";
+}
+
+std::uint64_t AutoExport::optionsHash(std::string_view key, std::string_view theme) {
+  auto &cfg = PreviewConfig::instance();
+  std::string id = std::string{ key } + '\n' + std::string{ theme };
+  if (options_generation_ == cfg.generation() && options_for_ == id) {
+    return options_hash_;
+  }
+
+  // Unrelated preferences (tweaks, zoom, pane size) don't force a re-export
+  std::vector<std::pair<std::string_view, const PreviewConfig::setting_value_type *>> sorted;
+  for (std::size_t i = 0; i < cfg.size(); ++i) {
+    if (affectsOutput(cfg.keyAt(i))) {
+      sorted.emplace_back(cfg.keyAt(i), &cfg.valueAt(i));
+    }
+  }
+  std::sort(sorted.begin(), sorted.end());
+
+  std::string text = id;
+  for (const auto &[name, value] : sorted) {
+    text += '\n';
+    text += name;
+    text += '=';
+    std::visit([&](const auto &v) { appendValue(text, v); }, *value);
+  }
+
+  options_hash_ = BlockHashes::hashBytes(text);
+  options_generation_ = cfg.generation();
+  options_for_ = std::move(id);
+  return options_hash_;
+}
+
+void AutoExport::start(Request request) {
+  std::string source = request.snapshot->filePath();
+  running_[request.dest.string()].reset();
+
+  ThreadPool::instance().post([this, source, request = std::move(request)]() {
+    bool ok = false;
+    bool exported = false;
+    try {
+      ok = exportPage(request, exported);
+    } catch (...) {
+      // Reported as a failure; the next save is exported as usual
+    }
+
+    MainThread::instance().post([source, dest = request.dest, ok, exported] {
+      instance().finished(source, dest, ok, exported);
+    });
+  });
+}
+
+void AutoExport::finished(
+    const std::string &source,
+    const std::filesystem::path &dest,
+    bool ok,
+    bool exported
+) {
+  if (!ok) {
+    msgwin_status_add("Preview: Auto-export failed for %s", source.c_str());
+  } else if (exported) {
+    msgwin_status_add("Preview: Auto-exported %s", dest.string().c_str());
+  }
+
+  auto it = running_.find(dest.string());
+  if (it == running_.end()) {
+    return;
+  }
+  if (it->second) {
+    start(std::move(*it->second));
+  } else {
+    running_.erase(it);
+  }
+}
+
+bool AutoExport::exportPage(const Request &request, bool &exported) {
+  exported = false;
+  std::filesystem::path dir = request.dest.parent_path();
+  std::string name = request.dest.filename().string();
+  std::optional<Entry> previous;
+  {
+    std::lock_guard lock(mutex_);
+    auto &entries = manifest(dir);
+    if (auto it = entries.find(name); it != entries.end()) {
+      previous = it->second;
+    }
+  }
+
+  // Same text and options select the same converter, so its stylesheet is
+  // the one to compare
+  std::error_code ec;
+  if (previous && previous->text == request.text_hash &&
+      previous->options == request.options_hash &&
+      previous->assets == assetsHash(previous->asset_files) &&
+      previous->css ==
+          BlockHashes::hashBytes(ExportHtml::stylesheet(previous->key, request.theme)) &&
+      std::filesystem::exists(request.dest, ec)) {
+    return true;
+  }
+
+  const auto &snapshot = *request.snapshot;
+  std::string_view key;
+  std::string body = PreviewPane::instance().exportHtml(snapshot, &key);
+  if (key.empty()) {
+    key = request.key;
+  }
+  std::string css = ExportHtml::stylesheet(key, request.theme);
+  Entry entry{ request.text_hash, request.options_hash, BlockHashes::hashBytes(css) };
+  entry.key = key;
+
+  std::string title = std::filesystem::path(snapshot.filePath()).stem().string();
+  std::vector<std::filesystem::path> files;
+  if (!ExportHtml::writePage(request.dest, body, title, css, request.asset_dir, &files)) {
+    return false;
+  }
+  exported = true;
+
+  for (const auto &file : files) {
+    entry.asset_files.push_back(file.string());
+  }
+  std::sort(entry.asset_files.begin(), entry.asset_files.end());
+  entry.asset_files.erase(
+      std::unique(entry.asset_files.begin(), entry.asset_files.end()), entry.asset_files.end()
+  );
+  entry.assets = assetsHash(entry.asset_files);
+
+  std::lock_guard lock(mutex_);
+  manifest(dir)[name] = entry;
+  return saveManifest(dir);
+}
+
+AutoExport::Manifest &AutoExport::manifest(const std::filesystem::path &dir) {
+  auto [it, inserted] = manifests_.try_emplace(dir.string());
+  if (!inserted) {
+    return it->second;
+  }
+
+  // One line per page: text, options, css and assets hashes, the converter
+  // key, then the file name, followed by a tab-indented line per asset file
+  std::ifstream file(dir / kManifestName);
+  std::string line;
+  Entry *last = nullptr;
+  while (std::getline(file, line)) {
+    if (line.starts_with('\t')) {
+      if (last) {
+        last->asset_files.push_back(line.substr(1));
+      }
+      continue;
+    }
+
+    std::istringstream in(line);
+    Entry entry;
+    std::string name;
+    last = nullptr;
+    if (in >> std::hex >> entry.text >> entry.options >> entry.css >> entry.assets >>
+            entry.key &&
+        in.get() == ' ' && std::getline(in, name) && !name.empty()) {
+      last = &(it->second[name] = std::move(entry));
+    }
+  }
+  return it->second;
+}
+
+bool AutoExport::saveManifest(const std::filesystem::path &dir) {
+  std::ostringstream out;
+  out << std::hex;
+  for (const auto &[name, entry] : manifests_[dir.string()]) {
+    out << entry.text << ' ' << entry.options << ' ' << entry.css << ' ' << entry.assets << ' '
+        << entry.key << ' ' << name << '\n';
+    for (const auto &asset : entry.asset_files) {
+      out << '\t' << asset << '\n';
+    }
+  }
+  return ExportHtml::writeFile(dir / kManifestName, out.str());
+}
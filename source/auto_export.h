@@ -0,0 +1,116 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "document_snapshot.h"
+
+class ConverterRegistrar;
+class DocumentGeany;
+
+// Exports documents to HTML in auto_export_dir each time they are saved.
+//
+// A manifest in the output folder records what each page was made from: the
+// text, the settings that affect conversion, the stylesheet and, for
+// self-contained pages, the files they embed.  A save that changes none of
+// them writes nothing.  Conversion and writing run on the
+// worker pool, one export per output file at a time; a save made while one
+// runs is exported after it.
+class AutoExport final {
+ public:
+  static AutoExport &instance() {
+    static AutoExport inst;
+    return inst;
+  }
+
+ private:
+  AutoExport() = default;
+  ~AutoExport() = default;
+
+  AutoExport(const AutoExport &) = delete;
+  AutoExport &operator=(const AutoExport &) = delete;
+  AutoExport(AutoExport &&) = delete;
+  AutoExport &operator=(AutoExport &&) = delete;
+
+ public:
+  // Main thread
+  void documentSaved(const DocumentGeany &document);
+
+ private:
+  static constexpr const char *kManifestName = ".preview-export";
+
+  struct Request {
+    std::shared_ptr<const DocumentSnapshot> snapshot;
+    std::string_view key;
+    std::string theme;
+    std::filesystem::path dest;
+    std::filesystem::path asset_dir;  // set to inline assets
+    std::uint64_t text_hash = 0;
+    std::uint64_t options_hash = 0;
+  };
+
+  struct Entry {
+    std::uint64_t text = 0;
+    std::uint64_t options = 0;
+    std::uint64_t css = 0;
+    std::uint64_t assets = 0;  // sizes and mtimes of asset_files
+    std::string key;           // converter that rendered the body, for css
+    std::vector<std::string> asset_files;
+  };
+
+  // Output file name -> what it was exported from
+  using Manifest = std::unordered_map<std::string, Entry>;
+
+  static std::filesystem::path outputDir(const std::filesystem::path &source);
+  // source.stem() + ".html", or source.filename() + ".html" if another
+  // convertible file in its folder has the same stem
+  std::string
+  outputName(const std::filesystem::path &source, const ConverterRegistrar &registrar);
+  // Settings that may change the output; recomputed when the config changes
+  std::uint64_t optionsHash(std::string_view key, std::string_view theme);
+
+  void start(Request request);
+  void finished(
+      const std::string &source,
+      const std::filesystem::path &dest,
+      bool ok,
+      bool exported
+  );
+
+  // Worker thread.  Returns false on failure; exported is false if the page
+  // was up to date.
+  bool exportPage(const Request &request, bool &exported);
+
+  // Callers hold mutex_
+  Manifest &manifest(const std::filesystem::path &dir);
+  bool saveManifest(const std::filesystem::path &dir);
+
+  // Main thread: output files being written, with the save waiting behind
+  // each.  By output, not source: a.md and a.rst both export to a.html.
+  std::unordered_map<std::string, std::optional<Request>> running_;
+
+  // Stems shared by convertible files, by folder, as of the folder's mtime
+  struct SharedStems {
+    std::filesystem::file_time_type mtime;
+    std::unordered_set<std::string> stems;
+  };
+  std::unordered_map<std::string, SharedStems> shared_stems_;
+
+  std::uint64_t options_hash_ = 0;
+  std::uint64_t options_generation_ = ~std::uint64_t{ 0 };
+  std::string options_for_;  // key and theme of options_hash_
+
+  std::mutex mutex_;
+  std::unordered_map<std::string, Manifest> manifests_;  // by output folder
+};
@@ -0,0 +1,532 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "batch_export.h"
+
+#include <algorithm>
+#include <system_error>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <msgwindow.h>
+
+#include "converter_registrar.h"
+#include "document_geany.h"
+#include "document_local.h"
+#include "document_snapshot.h"
+#include "export_html.h"
+#include "fountain_pdf.h"
+#include "offscreen_pdf.h"
+#include "preview_config.h"
+#include "preview_context.h"
+#include "preview_pane.h"
+#include "util/main_thread.h"
+#include "util/thread_pool.h"
+#include "webview.h"
+
+namespace {
+const char *extensionFor(BatchExport::Format format) {
+  return format == BatchExport::Format::Pdf ? ".pdf" : ".html";
+}
+
+std::string directoryUri(const std::filesystem::path &file) {
+  std::string out;
+  if (file.has_parent_path()) {
+    if (gchar *uri = g_filename_to_uri((file.parent_path() / "").c_str(), nullptr, nullptr)) {
+      out = uri;
+      g_free(uri);
+    }
+  }
+  return out;
+}
+}  // namespace
+
+void BatchExport::exportOpenDocuments(Format format, const std::filesystem::path &output_dir) {
+  auto &ctx = PreviewContext::instance();
+  if (running() || !ctx.geany_data_) {
+    return;
+  }
+
+  auto run = std::make_shared<Run>();
+  run->format = format;
+  run->output_dir = output_dir;
+
+  // Key lookups only; converters are created on the workers
+  ConverterRegistrar registrar;
+  std::unordered_set<std::string> names;
+
+  auto *docs = ctx.geany_data_->documents_array;
+  for (guint i = 0; i < docs->len; ++i) {
+    auto *gdoc = static_cast<GeanyDocument *>(g_ptr_array_index(docs, i));
+    if (!DOC_VALID(gdoc)) {
+      continue;
+    }
+    DocumentGeany doc(gdoc);
+    std::string_view key = registrar.getConverterKey(doc);
+    if (key.empty()) {
+      continue;
+    }
+
+    // Open documents from different folders may share a name
+    std::filesystem::path source = doc.filePath();
+    std::string stem = source.empty() ? "untitled" : source.stem().string();
+    std::string name = stem + extensionFor(format);
+    for (int n = 2; !names.insert(name).second; ++n) {
+      name = stem + "-" + std::to_string(n) + extensionFor(format);
+    }
+
+    run->jobs.push_back({ source,
+                          doc.snapshot(),
+                          output_dir / name,
+                          key,
+                          ConverterRegistrar::isExternal(key) });
+  }
+
+  run_ = run;
+  showProgress();
+  start(std::move(run));
+}
+
+void BatchExport::exportDirectory(
+    const std::filesystem::path &dir,
+    Format format,
+    const std::filesystem::path &output_dir
+) {
+  if (running()) {
+    return;
+  }
+
+  auto run = std::make_shared<Run>();
+  run->format = format;
+  run->output_dir = output_dir;
+
+  run_ = run;
+  showProgress();
+  progress_.setStatus("Searching for documents…");
+
+  ThreadPool::instance().post([run, dir]() {
+    auto jobs = std::make_shared<std::vector<Job>>();
+    try {
+      *jobs = collect(*run, dir);
+    } catch (...) {
+      // Reported as finding nothing, rather than leaving the run waiting
+    }
+    MainThread::instance().post([run, jobs] {
+      run->jobs = std::move(*jobs);
+      instance().start(run);
+    });
+  });
+}
+
+std::vector<BatchExport::Job>
+BatchExport::collect(const Run &run, const std::filesystem::path &dir) {
+  namespace fs = std::filesystem;
+  std::error_code ec;
+  const fs::path root = fs::weakly_canonical(dir, ec);
+  const fs::path output_dir = fs::weakly_canonical(run.output_dir, ec);
+
+  std::vector<Job> jobs;
+  ConverterRegistrar registrar;
+  auto opts = fs::directory_options::skip_permission_denied;
+  for (fs::recursive_directory_iterator it(root, opts, ec), end; !ec && it != end;
+       it.increment(ec)) {
+    if (run.cancelled) {
+      return {};
+    }
+
+    std::error_code entry_ec;
+    const auto &path = it->path();
+    if (it->is_directory(entry_ec)) {
+      // Hidden folders and earlier exports into the tree
+      if (path.filename().string().starts_with('.') || path == output_dir) {
+        it.disable_recursion_pending();
+      }
+      continue;
+    }
+    if (!it->is_regular_file(entry_ec)) {
+      continue;
+    }
+
+    std::string ext = path.extension().string();
+    std::string_view key = ext.size() > 1 ? registrar.getConverterKey(ext.substr(1)) : "";
+    if (key.empty() || key == "html" || key == "plaintext") {
+      continue;
+    }
+
+    fs::path dest = run.output_dir / path.lexically_relative(root);
+    dest.replace_extension(extensionFor(run.format));
+    jobs.push_back({ path, nullptr, dest, key, ConverterRegistrar::isExternal(key) });
+  }
+
+  // notes.md and notes.rst would both write notes.html: colliding names keep
+  // the source extension instead (notes.md.html, notes.rst.html)
+  std::unordered_map<std::string, std::size_t> uses;
+  for (const auto &job : jobs) {
+    ++uses[job.dest.string()];
+  }
+  for (auto &job : jobs) {
+    if (uses[job.dest.string()] > 1) {
+      job.dest.replace_filename(job.source.filename().string() + extensionFor(run.format));
+    }
+  }
+
+  std::sort(jobs.begin(), jobs.end(), [](const Job &a, const Job &b) {
+    return a.source < b.source;
+  });
+  return jobs;
+}
+
+void BatchExport::start(std::shared_ptr<Run> run) {
+  if (run != run_) {
+    return;
+  }
+  run->started = true;
+  if (run->cancelled || run->jobs.empty()) {
+    finishRun();
+    return;
+  }
+
+  auto &cfg = PreviewConfig::instance();
+  run->theme = cfg.get(Settings::kThemeMode);
+  run->self_contained = cfg.get(Settings::kExportSelfContained);
+  for (std::size_t i = 0; i < run->jobs.size(); ++i) {
+    const auto &job = run->jobs[i];
+    if (!run->stylesheets.contains(job.key)) {
+      run->stylesheets.emplace(job.key, ExportHtml::stylesheet(job.key, run->theme));
+    }
+    (job.external ? run->pending_external : run->pending_internal).push_back(i);
+  }
+
+  // One pool thread is left for the preview unless configured otherwise
+  int jobs = cfg.get(Settings::kBatchExportJobs);
+  std::size_t workers = ThreadPool::instance().concurrency() - 1;
+  run->limit_internal =
+      jobs > 0 ? static_cast<std::size_t>(jobs) : std::max<std::size_t>(workers - 1, 1);
+  run->limit_external =
+      static_cast<std::size_t>(std::max(cfg.get(Settings::kBatchExportExternalJobs), 1));
+
+  updateProgress({});
+  dispatch();
+}
+
+void BatchExport::dispatch() {
+  auto run = run_;
+  if (!run) {
+    return;
+  }
+
+  auto post = [&](std::deque<std::size_t> &pending, std::size_t &active, std::size_t limit) {
+    while (!pending.empty() && active < limit && !run->cancelled) {
+      if (run->format == Format::Pdf && run->prints.size() >= kMaxQueuedPrints) {
+        return;
+      }
+      std::size_t index = pending.front();
+      pending.pop_front();
+      ++active;
+
+      ThreadPool::instance().post([run, index]() {
+        auto result = std::make_shared<Result>(Result{ run, index });
+        try {
+          convert(*run, run->jobs[index], *result);
+        } catch (...) {
+          result->ok = false;
+        }
+        MainThread::instance().post([result] { onConverted(result); });
+      });
+    }
+  };
+
+  post(run->pending_internal, run->active_internal, run->limit_internal);
+  post(run->pending_external, run->active_external, run->limit_external);
+}
+
+void BatchExport::convert(const Run &run, const Job &job, Result &result) {
+  if (run.cancelled) {
+    result.skipped = true;
+    return;
+  }
+
+  std::shared_ptr<const Document> document = job.document;
+  if (!document) {
+    document = std::make_shared<DocumentLocal>(job.source, DocumentLocal::read(job.source));
+  }
+
+#ifdef HAVE_PODOFO
+  if (run.format == Format::Pdf && job.key == "fountain") {
+    result.ok = FountainPdf::instance().write(*document, job.dest, run.cancelled);
+    result.skipped = !result.ok && run.cancelled;
+    return;
+  }
+#endif
+
+  std::string title = job.source.empty() ? "untitled" : job.source.stem().string();
+  std::string_view key;
+  std::string body = PreviewPane::instance().exportHtml(*document, &key);
+
+  // Front matter or routing may pick another converter than the file type's
+  if (key.empty()) {
+    key = job.key;
+  }
+  std::string other;
+  auto it = run.stylesheets.find(key);
+  if (it == run.stylesheets.end()) {
+    other = ExportHtml::stylesheet(key, run.theme);
+  }
+  const std::string &css = it != run.stylesheets.end() ? it->second : other;
+
+  if (run.format == Format::Html) {
+    std::filesystem::path asset_dir = run.self_contained ? job.source.parent_path()
+                                                        : std::filesystem::path{};
+    result.ok = ExportHtml::writePage(job.dest, body, title, css, asset_dir);
+    return;
+  }
+
+  // Printing needs a web view, which lives on the main thread
+  result.html = ExportHtml::page(body, title, css);
+  result.base_uri = directoryUri(job.source);
+  result.ok = true;
+}
+
+void BatchExport::onConverted(const std::shared_ptr<Result> &result) {
+  auto &run = *result->run;
+  auto &self = instance();
+
+  --(run.jobs[result->index].external ? run.active_external : run.active_internal);
+  if (result->run != self.run_) {
+    return;
+  }
+
+  if (result->ok && !result->html.empty() && !run.cancelled) {
+    run.prints.push_back(
+        { result->index, std::move(result->html), std::move(result->base_uri) }
+    );
+    self.printNext();
+  } else {
+    bool skipped = result->skipped || (run.cancelled && !result->html.empty());
+    self.jobFinished(result->index, result->ok && !skipped, skipped);
+  }
+
+  self.dispatch();
+}
+
+void BatchExport::printNext() {
+  auto run = run_;
+  if (!run || run->printing || run->prints.empty()) {
+    return;
+  }
+
+  auto print = std::move(run->prints.front());
+  run->prints.pop_front();
+  run->printing = true;
+
+  auto &wv = WebView::instance();
+  OffscreenPdf::Options options;
+  options.context = wv.context();
+  options.settings = wv.settings();
+
+  const auto &dest = run->jobs[print.index].dest;
+  run->print_id = OffscreenPdf::print(
+      print.html,
+      print.base_uri,
+      dest,
+      [run, index = print.index](bool ok) {
+        auto &self = instance();
+        run->printing = false;
+        if (run != self.run_) {
+          return;
+        }
+        self.jobFinished(index, ok, !ok && run->cancelled);
+        self.printNext();
+        self.dispatch();
+      },
+      std::move(options)
+  );
+}
+
+void BatchExport::jobFinished(std::size_t index, bool ok, bool skipped) {
+  auto &run = *run_;
+  const auto &job = run.jobs[index];
+
+  ++run.done;
+  if (ok) {
+    ++run.exported;
+  } else if (!skipped) {
+    ++run.failed;
+    const auto &name = job.source.empty() ? job.dest : job.source;
+    msgwin_status_add("Preview: Failed to export %s", name.c_str());
+  }
+
+  updateProgress(job.dest.filename().string());
+  if (idle()) {
+    finishRun();
+  }
+}
+
+bool BatchExport::idle() const {
+  const auto &run = *run_;
+  return run.pending_internal.empty() && run.pending_external.empty() &&
+         run.active_internal == 0 && run.active_external == 0 && run.prints.empty() &&
+         !run.printing;
+}
+
+void BatchExport::cancel() {
+  if (!run_) {
+    return;
+  }
+
+  auto &run = *run_;
+  run.cancelled = true;
+  run.done += run.pending_internal.size() + run.pending_external.size() + run.prints.size();
+  run.pending_internal.clear();
+  run.pending_external.clear();
+  run.prints.clear();
+  if (run.printing) {
+    OffscreenPdf::cancel(run.print_id);
+  }
+
+  progress_.setStatus("Cancelling…");
+  // Otherwise the search or the conversions in progress finish the run
+  if (run.started && idle()) {
+    finishRun();
+  }
+}
+
+void BatchExport::finishRun() {
+  auto run = std::move(run_);
+
+  std::string summary = run->cancelled ? "Batch export cancelled: " : "Batch export finished: ";
+  summary += std::to_string(run->exported) + " exported";
+  if (run->failed > 0) {
+    summary += ", " + std::to_string(run->failed) + " failed";
+  }
+  summary += ".";
+  msgwin_status_add("Preview: %s Output: %s", summary.c_str(), run->output_dir.c_str());
+
+  progress_.finish(summary, !run->cancelled);
+}
+
+void BatchExport::showProgress() {
+  progress_.start("Batch Export", [] { instance().cancel(); });
+}
+
+void BatchExport::updateProgress(std::string_view current) {
+  if (!run_) {
+    return;
+  }
+
+  const auto &run = *run_;
+  std::size_t total = run.jobs.size();
+  double fraction =
+      total > 0 ? static_cast<double>(run.done) / static_cast<double>(total) : 0.0;
+  std::string text = std::to_string(run.done) + " / " + std::to_string(total);
+  progress_.setProgress(fraction, text);
+
+  if (!run.cancelled) {
+    std::string label = current.empty() ? "Exporting…" : "Exported " + std::string{ current };
+    progress_.setStatus(label);
+  }
+}
+
+void BatchExport::showDialog(GtkWindow *parent) {
+  if (running()) {
+    progress_.present();
+    return;
+  }
+
+  GtkWidget *dialog = gtk_dialog_new_with_buttons(
+      "Batch Export",
+      parent,
+      static_cast<GtkDialogFlags>(GTK_DIALOG_MODAL | GTK_DIALOG_DESTROY_WITH_PARENT),
+      "_Cancel",
+      GTK_RESPONSE_CANCEL,
+      "_Export",
+      GTK_RESPONSE_ACCEPT,
+      nullptr
+  );
+  gtk_dialog_set_default_response(GTK_DIALOG(dialog), GTK_RESPONSE_ACCEPT);
+
+  GtkWidget *grid = gtk_grid_new();
+  gtk_grid_set_row_spacing(GTK_GRID(grid), 6);
+  gtk_grid_set_column_spacing(GTK_GRID(grid), 12);
+  gtk_container_set_border_width(GTK_CONTAINER(grid), 12);
+  gtk_box_pack_start(
+      GTK_BOX(gtk_dialog_get_content_area(GTK_DIALOG(dialog))), grid, true, true, 0
+  );
+
+  // Defaults: last choices, otherwise the current document's folder
+  DocumentGeany current(document_get_current());
+  std::string current_dir = std::filesystem::path(current.filePath()).parent_path().string();
+  std::string source_dir = !last_source_dir_.empty() ? last_source_dir_ : current_dir;
+  std::string output_dir = !last_output_dir_.empty() ? last_output_dir_ : source_dir;
+
+  GtkWidget *open_docs = gtk_radio_button_new_with_label(nullptr, "Open documents");
+  GtkWidget *folder = gtk_radio_button_new_with_label_from_widget(
+      GTK_RADIO_BUTTON(open_docs), "Folder and subfolders:"
+  );
+  gtk_toggle_button_set_active(GTK_TOGGLE_BUTTON(folder), last_use_directory_);
+
+  GtkWidget *source_chooser =
+      gtk_file_chooser_button_new("Folder to Export", GTK_FILE_CHOOSER_ACTION_SELECT_FOLDER);
+  if (!source_dir.empty()) {
+    gtk_file_chooser_set_current_folder(GTK_FILE_CHOOSER(source_chooser), source_dir.c_str());
+  }
+  gtk_widget_set_hexpand(source_chooser, true);
+  g_object_bind_property(folder, "active", source_chooser, "sensitive", G_BINDING_SYNC_CREATE);
+
+  GtkWidget *format = gtk_combo_box_text_new();
+  gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(format), "HTML");
+  gtk_combo_box_text_append_text(GTK_COMBO_BOX_TEXT(format), "PDF");
+  gtk_combo_box_set_active(GTK_COMBO_BOX(format), last_format_ == Format::Pdf ? 1 : 0);
+
+  GtkWidget *output_chooser =
+      gtk_file_chooser_button_new("Output Folder", GTK_FILE_CHOOSER_ACTION_SELECT_FOLDER);
+  if (!output_dir.empty()) {
+    gtk_file_chooser_set_current_folder(GTK_FILE_CHOOSER(output_chooser), output_dir.c_str());
+  }
+
+  auto label = [](const char *text) {
+    GtkWidget *w = gtk_label_new(text);
+    gtk_label_set_xalign(GTK_LABEL(w), 0.0f);
+    return w;
+  };
+
+  gtk_grid_attach(GTK_GRID(grid), open_docs, 0, 0, 2, 1);
+  gtk_grid_attach(GTK_GRID(grid), folder, 0, 1, 1, 1);
+  gtk_grid_attach(GTK_GRID(grid), source_chooser, 1, 1, 1, 1);
+  gtk_grid_attach(GTK_GRID(grid), label("Format:"), 0, 2, 1, 1);
+  gtk_grid_attach(GTK_GRID(grid), format, 1, 2, 1, 1);
+  gtk_grid_attach(GTK_GRID(grid), label("Output folder:"), 0, 3, 1, 1);
+  gtk_grid_attach(GTK_GRID(grid), output_chooser, 1, 3, 1, 1);
+  gtk_widget_show_all(dialog);
+
+  auto chosen = [](GtkWidget *chooser) {
+    std::string path;
+    if (char *filename = gtk_file_chooser_get_filename(GTK_FILE_CHOOSER(chooser))) {
+      path = filename;
+      g_free(filename);
+    }
+    return path;
+  };
+
+  if (gtk_dialog_run(GTK_DIALOG(dialog)) != GTK_RESPONSE_ACCEPT) {
+    gtk_widget_destroy(dialog);
+    return;
+  }
+
+  last_use_directory_ = gtk_toggle_button_get_active(GTK_TOGGLE_BUTTON(folder));
+  last_format_ = gtk_combo_box_get_active(GTK_COMBO_BOX(format)) == 1 ? Format::Pdf
+                                                                       : Format::Html;
+  last_source_dir_ = chosen(source_chooser);
+  last_output_dir_ = chosen(output_chooser);
+  gtk_widget_destroy(dialog);
+
+  if (last_output_dir_.empty()) {
+    msgwin_status_add("Preview: Batch export needs an output folder.");
+  } else if (!last_use_directory_) {
+    exportOpenDocuments(last_format_, last_output_dir_);
+  } else if (last_source_dir_.empty()) {
+    msgwin_status_add("Preview: Batch export needs a folder to export.");
+  } else {
+    exportDirectory(last_source_dir_, last_format_, last_output_dir_);
+  }
+}
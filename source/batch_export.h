@@ -0,0 +1,142 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <gtk/gtk.h>
+
+#include "document.h"
+#include "progress_dialog.h"
+
+// Exports many documents at once.  Documents are converted on the worker pool
+// while the editor stays responsive, and each output is written as soon as it
+// is ready.  Converters that run an external program get their own, smaller
+// limit so a tree of pandoc files doesn't start one process per core.
+class BatchExport final {
+ public:
+  static BatchExport &instance() {
+    static BatchExport inst;
+    return inst;
+  }
+
+ private:
+  BatchExport() = default;
+  ~BatchExport() = default;
+
+  BatchExport(const BatchExport &) = delete;
+  BatchExport &operator=(const BatchExport &) = delete;
+  BatchExport(BatchExport &&) = delete;
+  BatchExport &operator=(BatchExport &&) = delete;
+
+ public:
+  enum class Format { Html, Pdf };
+
+  // Asks for the documents, format and output folder, then starts.
+  void showDialog(GtkWindow *parent);
+
+  // Main thread.  Open documents are copied before this returns; folders are
+  // searched in the background for files that have a converter.
+  void exportOpenDocuments(Format format, const std::filesystem::path &output_dir);
+  void exportDirectory(
+      const std::filesystem::path &dir,
+      Format format,
+      const std::filesystem::path &output_dir
+  );
+
+  bool running() const noexcept {
+    return run_ != nullptr;
+  }
+
+  // Lets conversions in progress finish and skips the rest.
+  void cancel();
+
+ private:
+  struct Job {
+    std::filesystem::path source;
+    std::shared_ptr<const Document> document;  // null: read source on the worker
+    std::filesystem::path dest;
+    std::string_view key;
+    bool external = false;
+  };
+
+  // Shared with the workers; only cancelled is written while jobs run
+  struct Run {
+    Format format = Format::Html;
+    std::filesystem::path output_dir;
+    std::vector<Job> jobs;
+    std::unordered_map<std::string_view, std::string> stylesheets;  // by key
+    std::string theme;
+    bool self_contained = false;
+    std::atomic<bool> cancelled{ false };
+
+    // Main thread only
+    bool started = false;  // jobs are final
+    std::deque<std::size_t> pending_internal;
+    std::deque<std::size_t> pending_external;
+    std::size_t active_internal = 0;
+    std::size_t active_external = 0;
+    std::size_t limit_internal = 1;
+    std::size_t limit_external = 1;
+
+    struct Print {
+      std::size_t index;
+      std::string html;
+      std::string base_uri;
+    };
+    std::deque<Print> prints;
+    bool printing = false;
+    guint print_id = 0;
+
+    std::size_t done = 0;  // including failed and skipped
+    std::size_t exported = 0;
+    std::size_t failed = 0;
+  };
+
+  struct Result {
+    std::shared_ptr<Run> run;
+    std::size_t index = 0;
+    bool ok = false;
+    bool skipped = false;
+    std::string html;  // PDF pages still to be printed
+    std::string base_uri;
+  };
+
+  // PDF pages waiting for the printer hold their whole HTML; don't convert
+  // further ahead than this.
+  static constexpr std::size_t kMaxQueuedPrints = 4;
+
+  // Worker thread: convertible files under dir, for a run not yet started.
+  static std::vector<Job> collect(const Run &run, const std::filesystem::path &dir);
+  void start(std::shared_ptr<Run> run);
+  void dispatch();
+  void printNext();
+  void jobFinished(std::size_t index, bool ok, bool skipped);
+  bool idle() const;
+  void finishRun();
+
+  static void convert(const Run &run, const Job &job, Result &result);
+  static void onConverted(const std::shared_ptr<Result> &result);
+
+  void showProgress();
+  void updateProgress(std::string_view current);
+
+  std::shared_ptr<Run> run_;
+
+  ProgressDialog progress_;
+
+  // Remembered between dialogs
+  std::string last_source_dir_;
+  std::string last_output_dir_;
+  Format last_format_ = Format::Html;
+  bool last_use_directory_ = false;
+};
@@ -0,0 +1,178 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "block_hashes.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace {
+constexpr std::uint64_t kMul = 0x9e3779b97f4a7c15ULL;
+
+inline std::uint64_t fmix(std::uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+inline std::uint64_t load64(const char *p) {
+  std::uint64_t w;
+  std::memcpy(&w, p, sizeof(w));
+  return w;
+}
+}  // namespace
+
+std::uint64_t BlockHashes::hashBytes(std::string_view bytes, std::uint64_t seed) {
+  const char *p = bytes.data();
+  std::size_t n = bytes.size();
+
+  // Four independent lanes keep the multiplier pipeline busy
+  std::uint64_t h[4] = { seed ^ kMul, seed + n, seed ^ (n * kMul), ~seed };
+  while (n >= 32) {
+    for (int i = 0; i < 4; ++i) {
+      h[i] = (h[i] ^ load64(p + 8 * i)) * kMul;
+      h[i] ^= h[i] >> 29;
+    }
+    p += 32;
+    n -= 32;
+  }
+
+  std::uint64_t acc = fmix(h[0]) ^ (fmix(h[1]) * 3) ^ (fmix(h[2]) * 5) ^ (fmix(h[3]) * 7);
+  while (n >= 8) {
+    acc = fmix(acc ^ load64(p));
+    p += 8;
+    n -= 8;
+  }
+  if (n > 0) {
+    std::uint64_t tail = 0;
+    std::memcpy(&tail, p, n);
+    acc = fmix(acc ^ tail ^ (static_cast<std::uint64_t>(n) << 56));
+  }
+  return fmix(acc ^ bytes.size());
+}
+
+std::size_t BlockHashes::blockEnd(const TextSegments &text, std::size_t start) {
+  std::size_t from = start + kBlockSize - 1;
+  if (from >= text.size()) {
+    return text.size();
+  }
+
+  std::size_t limit = std::min(text.size(), start + kMaxBlockSize);
+  std::size_t nl = text.find('\n', from, limit);
+  return nl != std::string_view::npos ? nl + 1 : limit;
+}
+
+BlockHashes::Block BlockHashes::hashBlock(const TextSegments &text, std::size_t start) {
+  Block b;
+  b.offset = start;
+  b.length = blockEnd(text, start) - start;
+
+  TextSegments bytes = text.substr(start, b.length);
+  if (bytes.isContiguous()) {
+    b.hash = hashBytes(bytes.front());
+  } else {
+    scratch_.clear();
+    bytes.appendTo(scratch_);
+    b.hash = hashBytes(scratch_);
+  }
+  ++rehashed_;
+  return b;
+}
+
+void BlockHashes::rebuild(const TextSegments &text) {
+  rehashed_ = 0;
+  blocks_.clear();
+  blocks_.reserve(text.size() / kBlockSize + 1);
+  for (std::size_t pos = 0; pos < text.size(); pos += blocks_.back().length) {
+    blocks_.push_back(hashBlock(text, pos));
+  }
+  size_ = text.size();
+  valid_ = true;
+  computeDigest();
+}
+
+void BlockHashes::update(const TextSegments &text, const DirtyRanges &dirty) {
+  if (!valid_ || dirty.whole()) {
+    rebuild(text);
+    return;
+  }
+
+  // Ranges that don't add up to the new length were not the whole story
+  std::ptrdiff_t delta = 0;
+  for (const auto &r : dirty.ranges()) {
+    delta += static_cast<std::ptrdiff_t>(r.inserted) - static_cast<std::ptrdiff_t>(r.deleted);
+  }
+  if (static_cast<std::ptrdiff_t>(size_) + delta != static_cast<std::ptrdiff_t>(text.size())) {
+    rebuild(text);
+    return;
+  }
+  if (dirty.empty()) {
+    rehashed_ = 0;
+    return;
+  }
+
+  rehashed_ = 0;
+  const auto &ranges = dirty.ranges();
+  std::vector<Block> old = std::move(blocks_);
+  blocks_.clear();
+  blocks_.reserve(old.size() + ranges.size());
+
+  // Walk the new text.  Old blocks are mapped to new offsets by the edits
+  // passed so far and reused when they start exactly at pos and no edit
+  // reaches them; everything else is rehashed.
+  std::size_t pos = 0;
+  std::size_t oi = 0;
+  std::size_t ri = 0;
+  std::ptrdiff_t shift = 0;
+  auto mapped = [&](std::size_t i) {
+    return static_cast<std::ptrdiff_t>(old[i].offset) + shift;
+  };
+
+  while (pos < text.size()) {
+    while (ri < ranges.size() && ranges[ri].position + ranges[ri].inserted <= pos) {
+      shift += static_cast<std::ptrdiff_t>(ranges[ri].inserted) -
+               static_cast<std::ptrdiff_t>(ranges[ri].deleted);
+      ++ri;
+    }
+
+    // Skip old blocks already covered; blocks behind a pending edit stay put
+    // until the edit is passed and their offset is known
+    const std::ptrdiff_t next_edit = ri < ranges.size()
+                                         ? static_cast<std::ptrdiff_t>(ranges[ri].position)
+                                         : static_cast<std::ptrdiff_t>(text.size()) + 1;
+    while (oi < old.size() && mapped(oi) < static_cast<std::ptrdiff_t>(pos) &&
+           mapped(oi) < next_edit) {
+      ++oi;
+    }
+
+    if (oi < old.size() && mapped(oi) == static_cast<std::ptrdiff_t>(pos)) {
+      const std::size_t end = pos + old[oi].length;
+      const bool touched = ri < ranges.size() && ranges[ri].position <= end;
+      const bool complete = oi + 1 < old.size() || end == text.size();
+      if (!touched && complete && end <= text.size()) {
+        blocks_.push_back({ pos, old[oi].length, old[oi].hash });
+        pos = end;
+        ++oi;
+        continue;
+      }
+    }
+
+    blocks_.push_back(hashBlock(text, pos));
+    pos += blocks_.back().length;
+  }
+
+  size_ = text.size();
+  computeDigest();
+}
+
+void BlockHashes::computeDigest() {
+  std::uint64_t h = fmix(size_ ^ kMul);
+  for (const auto &b : blocks_) {
+    h = fmix(h ^ b.hash) * kMul;
+  }
+  digest_ = fmix(h);
+}
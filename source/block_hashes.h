@@ -0,0 +1,65 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "dirty_ranges.h"
+#include "text_segments.h"
+
+// Fast non-cryptographic hashes of a text, one per block plus a digest of the
+// whole.  Blocks end at the first newline after kBlockSize bytes, so a block is
+// determined by its own content only: after an edit, blocks are rehashed from
+// the one containing the edit until a boundary lines up with an old one again.
+class BlockHashes {
+ public:
+  struct Block {
+    std::size_t offset = 0;
+    std::size_t length = 0;
+    std::uint64_t hash = 0;
+  };
+
+  static std::uint64_t hashBytes(std::string_view bytes, std::uint64_t seed = 0);
+
+  // Rehashes everything.
+  void rebuild(const TextSegments &text);
+
+  // Rehashes only the blocks touched by dirty, which must describe every edit
+  // since the last update.  Falls back to rebuild() when it cannot.
+  void update(const TextSegments &text, const DirtyRanges &dirty);
+
+  const std::vector<Block> &blocks() const noexcept {
+    return blocks_;
+  }
+  std::uint64_t digest() const noexcept {
+    return digest_;
+  }
+  std::size_t size() const noexcept {
+    return size_;
+  }
+
+  // Number of blocks rehashed by the last update, for diagnostics.
+  std::size_t rehashed() const noexcept {
+    return rehashed_;
+  }
+
+ private:
+  static constexpr std::size_t kBlockSize = 16 * 1024;
+  static constexpr std::size_t kMaxBlockSize = 4 * kBlockSize;  // text without newlines
+
+  static std::size_t blockEnd(const TextSegments &text, std::size_t start);
+  Block hashBlock(const TextSegments &text, std::size_t start);
+  void computeDigest();
+
+  std::vector<Block> blocks_;
+  std::string scratch_;  // a block that straddles the gap
+  std::uint64_t digest_ = 0;
+  std::size_t size_ = 0;
+  std::size_t rehashed_ = 0;
+  bool valid_ = false;
+};
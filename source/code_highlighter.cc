@@ -0,0 +1,452 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "code_highlighter.h"
+
+#include <array>
+#include <cctype>
+#include <cstring>
+#include <unordered_set>
+#include <vector>
+
+struct CodeHighlighter::Language {
+  std::string_view names;          // space-separated info-string aliases
+  std::string_view keywords;       // space-separated
+  std::string_view literals;       // space-separated
+  std::string_view line_comments;  // space-separated prefixes
+  std::string_view block_open;
+  std::string_view block_close;
+  std::string_view quotes;  // characters that open a string
+  bool triple_quotes = false;
+  bool ignore_case = false;
+};
+
+namespace {
+
+using Language = CodeHighlighter::Language;
+
+// clang-format off
+const std::array kLanguages = {
+  Language{
+    "c h cpp c++ cc cxx hpp hxx",
+    "alignas alignof auto break case catch class const constexpr consteval "
+    "constinit continue co_await co_return co_yield decltype default delete do "
+    "else enum explicit export extern final for friend goto if inline "
+    "mutable namespace new noexcept operator override private protected public "
+    "register requires return sizeof static static_assert static_cast struct "
+    "switch template this throw try typedef typename union using virtual "
+    "volatile while bool char double float int long short signed unsigned void "
+    "size_t int8_t int16_t int32_t int64_t uint8_t uint16_t uint32_t uint64_t "
+    "dynamic_cast reinterpret_cast const_cast",
+    "true false nullptr NULL",
+    "//", "/*", "*/", "\"'", false, false },
+  Language{
+    "java kotlin kt cs csharp c# swift scala dart",
+    "abstract as break case catch class const continue default do else enum "
+    "extends final finally for fun func if implements import in interface "
+    "internal is let namespace new object override package private protected "
+    "public return sealed static struct super switch this throw throws try val "
+    "var void when while boolean byte char double float int long short string",
+    "true false null nil",
+    "//", "/*", "*/", "\"'", true, false },
+  Language{
+    "js javascript jsx mjs ts typescript tsx json jsonc",
+    "async await break case catch class const continue debugger default delete "
+    "do else export extends finally for from function if import in instanceof "
+    "interface let new of return static super switch this throw try type "
+    "typeof var void while with yield",
+    "true false null undefined NaN Infinity",
+    "//", "/*", "*/", "\"'`", false, false },
+  Language{
+    "py python python3 pyi",
+    "and as assert async await break class continue def del elif else except "
+    "finally for from global if import in is lambda nonlocal not or pass raise "
+    "return try while with yield match case self",
+    "True False None",
+    "#", "", "", "\"'", true, false },
+  Language{
+    "sh bash shell zsh ksh console",
+    "case do done elif else esac fi for function if in local readonly return "
+    "select then until while export set unset shift source alias cd echo exit "
+    "printf read test trap",
+    "true false",
+    "#", "", "", "\"'", false, false },
+  Language{
+    "rust rs",
+    "as async await break const continue crate dyn else enum extern fn for if "
+    "impl in let loop match mod move mut pub ref return self Self static struct "
+    "super trait type unsafe use where while i8 i16 i32 i64 i128 isize u8 u16 "
+    "u32 u64 u128 usize f32 f64 bool char str String Vec Option Result Some "
+    "None Ok Err",
+    "true false",
+    "//", "/*", "*/", "\"", false, false },
+  Language{
+    "go golang",
+    "break case chan const continue default defer else fallthrough for func go "
+    "goto if import interface map package range return select struct switch "
+    "type var bool byte error float32 float64 int int8 int16 int32 int64 rune "
+    "string uint uint8 uint16 uint32 uint64 uintptr",
+    "true false nil iota",
+    "//", "/*", "*/", "\"'`", false, false },
+  Language{
+    "lua",
+    "and break do else elseif end for function goto if in local not or repeat "
+    "return then until while",
+    "true false nil",
+    "--", "--[[", "]]", "\"'", false, false },
+  Language{
+    "rb ruby",
+    "alias and begin break case class def defined? do else elsif end ensure "
+    "for if in module next not or redo rescue retry return self super then "
+    "undef unless until when while yield require",
+    "true false nil",
+    "#", "", "", "\"'", false, false },
+  Language{
+    "sql mysql pgsql postgresql sqlite",
+    "add all alter and as asc begin between by case check column commit "
+    "constraint create cross database default delete desc distinct drop else "
+    "end exists foreign from full group having in index inner insert into is "
+    "join key left like limit not offset on or order outer primary references "
+    "right rollback select set table then transaction union unique update "
+    "values view when where with integer int text varchar char real blob",
+    "true false null",
+    "--", "/*", "*/", "'\"", false, true },
+  Language{
+    "toml ini conf cfg",
+    "",
+    "true false",
+    "# ;", "", "", "\"'", true, false },
+  Language{
+    "yaml yml",
+    "",
+    "true false null yes no on off",
+    "#", "", "", "\"'", false, false },
+};
+// clang-format on
+
+using WordSet = std::unordered_set<std::string_view>;
+
+WordSet splitWords(std::string_view list) {
+  WordSet words;
+  std::size_t pos = 0;
+  while (pos < list.size()) {
+    auto end = list.find(' ', pos);
+    if (end == std::string_view::npos) {
+      end = list.size();
+    }
+    if (end > pos) {
+      words.insert(list.substr(pos, end - pos));
+    }
+    pos = end + 1;
+  }
+  return words;
+}
+
+struct LanguageWords {
+  WordSet keywords;
+  WordSet literals;
+  WordSet line_comments;
+};
+
+const LanguageWords &wordsFor(const Language &lang) {
+  static const std::vector<LanguageWords> words = [] {
+    std::vector<LanguageWords> v;
+    v.reserve(kLanguages.size());
+    for (const auto &l : kLanguages) {
+      v.push_back(
+          { splitWords(l.keywords), splitWords(l.literals), splitWords(l.line_comments) }
+      );
+    }
+    return v;
+  }();
+  return words[&lang - kLanguages.data()];
+}
+
+bool isIdentStart(char c) {
+  return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool isIdentChar(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+
+void appendEscaped(std::string &out, std::string_view text) {
+  for (char c : text) {
+    switch (c) {
+      case '&':
+        out += "&amp;";
+        break;
+      case '<':
+        out += "&lt;";
+        break;
+      case '>':
+        out += "&gt;";
+        break;
+      case '"':
+        out += "&quot;";
+        break;
+      default:
+        out += c;
+    }
+  }
+}
+
+void appendSpan(std::string &out, const char *cls, std::string_view text) {
+  out += "<span class=\"";
+  out += cls;
+  out += "\">";
+  appendEscaped(out, text);
+  out += "</span>";
+}
+
+// Reverses the escaping done by the Markdown converters.
+std::string unescapeHtml(std::string_view text) {
+  static constexpr std::array<std::pair<std::string_view, char>, 7> kEntities = { {
+      { "&amp;", '&' },
+      { "&lt;", '<' },
+      { "&gt;", '>' },
+      { "&quot;", '"' },
+      { "&#39;", '\'' },
+      { "&#x27;", '\'' },
+      { "&#x22;", '"' },
+  } };
+
+  std::string out;
+  out.reserve(text.size());
+  for (std::size_t i = 0; i < text.size(); ++i) {
+    if (text[i] == '&') {
+      bool matched = false;
+      for (const auto &[entity, ch] : kEntities) {
+        if (text.compare(i, entity.size(), entity) == 0) {
+          out += ch;
+          i += entity.size() - 1;
+          matched = true;
+          break;
+        }
+      }
+      if (matched) {
+        continue;
+      }
+    }
+    out += text[i];
+  }
+  return out;
+}
+
+std::uint64_t hashBlock(std::size_t lang_index, std::string_view text) {
+  std::uint64_t h = 1469598103934665603ULL ^ lang_index;
+  for (unsigned char c : text) {
+    h ^= c;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+bool startsWithAt(std::string_view s, std::size_t pos, std::string_view prefix) {
+  return !prefix.empty() && s.compare(pos, prefix.size(), prefix) == 0;
+}
+
+}  // namespace
+
+const CodeHighlighter::Language *CodeHighlighter::findLanguage(std::string_view name) {
+  std::string lower;
+  lower.reserve(name.size());
+  for (char c : name) {
+    lower += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+  }
+
+  for (const auto &lang : kLanguages) {
+    std::size_t pos = 0;
+    while (pos < lang.names.size()) {
+      auto end = lang.names.find(' ', pos);
+      if (end == std::string_view::npos) {
+        end = lang.names.size();
+      }
+      if (lang.names.substr(pos, end - pos) == lower) {
+        return &lang;
+      }
+      pos = end + 1;
+    }
+  }
+  return nullptr;
+}
+
+void CodeHighlighter::tokenize(const Language &lang, std::string_view code, std::string &out) {
+  const auto &words = wordsFor(lang);
+
+  std::size_t i = 0;
+  std::size_t plain_start = 0;
+  auto flushPlain = [&](std::size_t end) {
+    if (end > plain_start) {
+      appendEscaped(out, code.substr(plain_start, end - plain_start));
+    }
+  };
+  auto emit = [&](const char *cls, std::size_t begin, std::size_t end) {
+    flushPlain(begin);
+    appendSpan(out, cls, code.substr(begin, end - begin));
+    plain_start = end;
+    i = end;
+  };
+
+  while (i < code.size()) {
+    char c = code[i];
+
+    // Block comments are checked first so "--[[" wins over "--" in Lua.
+    if (startsWithAt(code, i, lang.block_open)) {
+      auto close = code.find(lang.block_close, i + lang.block_open.size());
+      auto end = close == std::string_view::npos ? code.size() : close + lang.block_close.size();
+      emit("hl-com", i, end);
+      continue;
+    }
+
+    bool line_comment = false;
+    for (auto prefix : words.line_comments) {
+      // '#' only starts a comment at a word boundary (e.g. not in "$#" or "a#b").
+      if (startsWithAt(code, i, prefix) &&
+          (prefix != "#" || i == 0 || std::isspace(static_cast<unsigned char>(code[i - 1])))) {
+        line_comment = true;
+        break;
+      }
+    }
+    if (line_comment) {
+      auto end = code.find('\n', i);
+      emit("hl-com", i, end == std::string_view::npos ? code.size() : end);
+      continue;
+    }
+
+    if (lang.quotes.find(c) != std::string_view::npos) {
+      if (lang.triple_quotes && code.compare(i, 3, std::string(3, c)) == 0) {
+        auto close = code.find(std::string(3, c), i + 3);
+        emit("hl-str", i, close == std::string_view::npos ? code.size() : close + 3);
+        continue;
+      }
+      std::size_t j = i + 1;
+      while (j < code.size() && code[j] != c && (code[j] != '\n' || c == '`')) {
+        j += (code[j] == '\\' && j + 1 < code.size()) ? 2 : 1;
+      }
+      emit("hl-str", i, j < code.size() && code[j] == c ? j + 1 : j);
+      continue;
+    }
+
+    if (std::isdigit(static_cast<unsigned char>(c)) && (i == 0 || !isIdentChar(code[i - 1]))) {
+      std::size_t j = i + 1;
+      while (j < code.size() && (isIdentChar(code[j]) || code[j] == '.')) {
+        ++j;
+      }
+      emit("hl-num", i, j);
+      continue;
+    }
+
+    if (isIdentStart(c) && (i == 0 || !isIdentChar(code[i - 1]))) {
+      std::size_t j = i + 1;
+      while (j < code.size() && isIdentChar(code[j])) {
+        ++j;
+      }
+      std::string_view word = code.substr(i, j - i);
+      std::string folded;
+      if (lang.ignore_case) {
+        folded.reserve(word.size());
+        for (char w : word) {
+          folded += static_cast<char>(std::tolower(static_cast<unsigned char>(w)));
+        }
+        word = folded;
+      }
+      if (words.keywords.count(word)) {
+        emit("hl-kw", i, j);
+      } else if (words.literals.count(word)) {
+        emit("hl-lit", i, j);
+      } else {
+        i = j;
+      }
+      continue;
+    }
+
+    ++i;
+  }
+  flushPlain(code.size());
+}
+
+std::string CodeHighlighter::highlightBlock(const Language &lang, std::string_view escaped) {
+  const std::uint64_t key = hashBlock(&lang - kLanguages.data(), escaped);
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (auto it = current_.find(key); it != current_.end()) {
+      return it->second;
+    }
+    if (auto it = previous_.find(key); it != previous_.end()) {
+      std::string html = std::move(it->second);
+      previous_.erase(it);
+      current_bytes_ += html.size();
+      current_.emplace(key, html);
+      return html;
+    }
+  }
+
+  std::string html;
+  html.reserve(escaped.size() * 2);
+  tokenize(lang, unescapeHtml(escaped), html);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (current_bytes_ + html.size() > kCacheMaxBytes) {
+    previous_ = std::move(current_);
+    current_.clear();
+    current_bytes_ = 0;
+  }
+  current_bytes_ += html.size();
+  current_.emplace(key, html);
+  return html;
+}
+
+void CodeHighlighter::appendHighlighted(std::string &out, std::string_view html) {
+  static constexpr std::string_view kCodeOpen = "<code class=\"language-";
+  static constexpr std::string_view kCodeClose = "</code>";
+
+  std::size_t copied = 0;
+  std::size_t pos = 0;
+  while ((pos = html.find(kCodeOpen, pos)) != std::string_view::npos) {
+    const std::size_t lang_begin = pos + kCodeOpen.size();
+    pos = lang_begin;
+
+    // Only fenced blocks: the code tag must directly follow a <pre ...> tag.
+    auto tag_begin = pos > kCodeOpen.size() + 1 ? html.rfind('<', pos - kCodeOpen.size() - 1)
+                                                : std::string_view::npos;
+    if (tag_begin == std::string_view::npos || html.compare(tag_begin, 4, "<pre") != 0 ||
+        html[pos - kCodeOpen.size() - 1] != '>') {
+      continue;
+    }
+
+    auto lang_end = html.find_first_of("\" ", lang_begin);
+    auto tag_end = html.find('>', lang_begin);
+    if (lang_end == std::string_view::npos || tag_end == std::string_view::npos) {
+      break;
+    }
+    const Language *lang = findLanguage(html.substr(lang_begin, lang_end - lang_begin));
+    if (!lang) {
+      continue;
+    }
+
+    const std::size_t body_begin = tag_end + 1;
+    auto body_end = html.find(kCodeClose, body_begin);
+    if (body_end == std::string_view::npos) {
+      break;
+    }
+    std::string_view body = html.substr(body_begin, body_end - body_begin);
+
+    // Leave blocks that already contain markup alone.
+    if (body.find('<') == std::string_view::npos) {
+      out.append(html.substr(copied, body_begin - copied));
+      out += highlightBlock(*lang, body);
+      copied = body_end;
+    }
+    pos = body_end + kCodeClose.size();
+  }
+  out.append(html.substr(copied));
+}
+
+void CodeHighlighter::clearCache() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  current_.clear();
+  previous_.clear();
+  current_bytes_ = 0;
+}
@@ -0,0 +1,55 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Highlights `<pre><code class="language-x">` blocks in converter output.
+// Results are cached per (language, block), so unchanged blocks cost only a
+// lookup on each update.
+class CodeHighlighter {
+ public:
+  static CodeHighlighter &instance() {
+    static CodeHighlighter inst;
+    return inst;
+  }
+
+ private:
+  CodeHighlighter() = default;
+  ~CodeHighlighter() = default;
+
+  CodeHighlighter(const CodeHighlighter &) = delete;
+  CodeHighlighter &operator=(const CodeHighlighter &) = delete;
+  CodeHighlighter(CodeHighlighter &&) = delete;
+  CodeHighlighter &operator=(CodeHighlighter &&) = delete;
+
+ public:
+  struct Language;
+
+  // Appends html to out, replacing the contents of recognized code blocks.
+  void appendHighlighted(std::string &out, std::string_view html);
+
+  void clearCache();
+
+ private:
+  // Returns highlighted HTML for one escaped code block, from cache if possible.
+  std::string highlightBlock(const Language &lang, std::string_view escaped);
+
+  static const Language *findLanguage(std::string_view name);
+  static void tokenize(const Language &lang, std::string_view code, std::string &out);
+
+  // Two generations: when the current one fills up, it replaces the previous
+  // one.  Blocks still in use are promoted back on their next lookup.
+  static constexpr std::size_t kCacheMaxBytes = 4 * 1024 * 1024;
+
+  std::mutex mutex_;
+  std::unordered_map<std::uint64_t, std::string> current_;
+  std::unordered_map<std::uint64_t, std::string> previous_;
+  std::size_t current_bytes_ = 0;
+};
@@ -6,6 +6,8 @@
 #include <string>
 #include <string_view>
 
+#include "text_segments.h"
+
 class Converter {
  public:
   virtual ~Converter() = default;
@@ -13,4 +15,23 @@ class Converter {
   virtual std::string_view id() const = 0;
 
   virtual std::string_view toHtml(std::string_view source) = 0;
+
+  // Source split in up to two pieces.  Joined here; converters that can
+  // consume their input in pieces override this.
+  virtual std::string_view toHtmlSegmented(const TextSegments &source) {
+    if (source.isContiguous()) {
+      return toHtml(source.front());
+    }
+    joined_.clear();
+    source.appendTo(joined_);
+    return toHtml(joined_);
+  }
+
+  // JSON side table of source positions for the last toHtml() output, if any.
+  virtual std::string_view sourcepos() const {
+    return {};
+  }
+
+ private:
+  std::string joined_;  // input of the last segmented call
 };
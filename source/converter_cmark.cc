@@ -3,11 +3,13 @@
 
 #include "converter_cmark.h"
 
+#include <cctype>
 #include <cstdlib>  // for free()
 #include <cstring>  // for std::strlen
 #include <memory>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 
 #ifdef HAVE_CMARK_GFM
 #  include <cmark-gfm-core-extensions.h>
@@ -16,6 +18,9 @@
 #  include <cmark.h>
 #endif
 
+#include "markdown_chunker.h"
+#include "preview_config.h"
+
 namespace {
 
 #ifdef HAVE_CMARK_GFM
@@ -27,16 +32,11 @@ void add_extension(cmark_parser *parser, const char *name) {
 }
 #endif
 
-}  // namespace
-
-std::string_view ConverterCmark::toHtml(std::string_view source) {
-  int options = CMARK_OPT_SOURCEPOS | CMARK_OPT_SMART;
-
-#ifdef HAVE_CMARK_GFM
-  options |= CMARK_OPT_TABLE_PREFER_STYLE_ATTRIBUTES | CMARK_OPT_FOOTNOTES;
-  cmark_gfm_core_extensions_ensure_registered();
-#endif
+// Below this size, splitting costs more than it saves
+constexpr std::size_t kMinChunkSize = 256 * 1024;
 
+// Parses and renders one Markdown string; returns cmark's malloc'd buffer.
+char *renderHtml(const TextSegments &source, int options) {
   cmark_parser *parser = cmark_parser_new(options);
 
 #ifdef HAVE_CMARK_GFM
@@ -47,7 +47,10 @@ std::string_view ConverterCmark::toHtml(std::string_view source) {
   add_extension(parser, "tasklist");
 #endif
 
-  cmark_parser_feed(parser, source.data(), source.size());
+  // The parser buffers partial lines, so the pieces need not end on one
+  for (std::size_t i = 0; i < source.count(); ++i) {
+    cmark_parser_feed(parser, source.part(i).data(), source.part(i).size());
+  }
   cmark_node *document = cmark_parser_finish(parser);
 
 #ifdef HAVE_CMARK_GFM
@@ -60,11 +63,155 @@ std::string_view ConverterCmark::toHtml(std::string_view source) {
   cmark_node_free(document);
   cmark_parser_free(parser);
 
-  // Take ownership of cmark's malloc'd buffer
-  html_owner_ = std::unique_ptr<char, decltype(&free)>(html_cstr, &free);
+  return html_cstr;
+}
+
+// Offset of the end tag of a raw text element (e.g. "</script"), or npos
+std::size_t findEndTag(std::string_view html, std::size_t pos, std::string_view tag) {
+  while ((pos = html.find("</", pos)) != std::string_view::npos) {
+    std::size_t i = 0;
+    while (i < tag.size() && pos + 2 + i < html.size() &&
+           std::tolower(static_cast<unsigned char>(html[pos + 2 + i])) == tag[i]) {
+      ++i;
+    }
+    if (i == tag.size()) {
+      return pos;
+    }
+    pos += 2;
+  }
+  return std::string_view::npos;
+}
+
+// Moves data-sourcepos attributes out of the HTML into a JSON side table.
+// Each entry is [tag, n, "l:c-l:c"], where n counts earlier start tags with the
+// same name, so the page can find the element with getElementsByTagName().
+// Tags in comments and in raw text (script, style, ...) never become elements
+// and are not counted.
+void extractSourcepos(std::string_view html, std::string &stripped, std::string &table) {
+  static constexpr std::string_view kAttr = " data-sourcepos=\"";
+
+  stripped.clear();
+  stripped.reserve(html.size());
+  table.assign("[");
+
+  std::unordered_map<std::string, std::size_t> tag_counts;
+  std::string tag;
+  std::size_t copied = 0;
+  std::size_t pos = 0;
+  while ((pos = html.find('<', pos)) != std::string_view::npos) {
+    if (html.compare(pos, 4, "<!--") == 0) {
+      pos = html.find("-->", pos + 4);
+      if (pos == std::string_view::npos) {
+        break;
+      }
+      continue;
+    }
+
+    std::size_t name_end = ++pos;
+    while (name_end < html.size() && std::isalnum(static_cast<unsigned char>(html[name_end]))) {
+      ++name_end;
+    }
+    if (name_end == pos || !std::isalpha(static_cast<unsigned char>(html[pos]))) {
+      continue;
+    }
+
+    tag.clear();
+    for (std::size_t i = pos; i < name_end; ++i) {
+      tag += static_cast<char>(std::tolower(static_cast<unsigned char>(html[i])));
+    }
+    std::size_t nth = tag_counts[tag]++;
+
+    if (tag == "script" || tag == "style" || tag == "textarea" || tag == "title") {
+      pos = findEndTag(html, name_end, tag);
+      if (pos == std::string_view::npos) {
+        break;
+      }
+      continue;
+    }
+
+    if (html.compare(name_end, kAttr.size(), kAttr) != 0) {
+      continue;
+    }
+    auto value_begin = name_end + kAttr.size();
+    auto value_end = html.find('"', value_begin);
+    if (value_end == std::string_view::npos) {
+      break;
+    }
+
+    if (table.size() > 1) {
+      table += ',';
+    }
+    table += "[\"" + tag + "\"," + std::to_string(nth) + ",\"";
+    table.append(html.substr(value_begin, value_end - value_begin));
+    table += "\"]";
+
+    stripped.append(html.substr(copied, name_end - copied));
+    copied = value_end + 1;
+    pos = copied;
+  }
+  stripped.append(html.substr(copied));
+  table += ']';
+}
+
+}  // namespace
 
-  // Point the view into the owned buffer
-  html_view_ = std::string_view(html_owner_.get(), std::strlen(html_owner_.get()));
+std::string_view ConverterCmark::toHtml(std::string_view source) {
+  return toHtmlSegmented(source);
+}
+
+std::string_view ConverterCmark::toHtmlSegmented(const TextSegments &source) {
+  auto &cfg = PreviewConfig::instance();
+  auto sourcepos_mode = cfg.get(Settings::kMarkdownSourcepos);
+
+  int options = CMARK_OPT_SMART;
+  if (sourcepos_mode != "none") {
+    options |= CMARK_OPT_SOURCEPOS;
+  }
+
+#ifdef HAVE_CMARK_GFM
+  options |= CMARK_OPT_TABLE_PREFER_STYLE_ATTRIBUTES | CMARK_OPT_FOOTNOTES;
+  cmark_gfm_core_extensions_ensure_registered();
+#endif
+
+  // Large documents: render top-level chunks in parallel
+  int parallel_min_size = cfg.get(Settings::kMarkdownParallelMinSize);
+  bool chunked = false;
+  if (parallel_min_size > 0 && source.size() >= static_cast<std::size_t>(parallel_min_size)) {
+    auto render = [options](std::string_view chunk) {
+      std::unique_ptr<char, decltype(&free)> html(renderHtml(chunk, options), &free);
+      return std::string(html ? html.get() : "");
+    };
+    // Chunking needs the source in one piece
+    std::string_view whole = source.front();
+    if (!source.isContiguous()) {
+      source_joined_ = source.str();
+      whole = source_joined_;
+    }
+    chunked = MarkdownChunker::render(
+        whole, kMinChunkSize, render, (options & CMARK_OPT_SOURCEPOS) != 0, html_chunked_
+    );
+    source_joined_.clear();
+  }
+
+  if (chunked) {
+    html_owner_.reset();
+    html_view_ = html_chunked_;
+  } else {
+    html_chunked_.clear();
+
+    // Take ownership of cmark's malloc'd buffer
+    html_owner_ = std::unique_ptr<char, decltype(&free)>(renderHtml(source, options), &free);
+
+    // Point the view into the owned buffer
+    html_view_ = std::string_view(html_owner_.get(), std::strlen(html_owner_.get()));
+  }
+
+  sourcepos_.clear();
+  html_stripped_.clear();
+  if (sourcepos_mode == "table") {
+    extractSourcepos(html_view_, html_stripped_, sourcepos_);
+    html_view_ = html_stripped_;
+  }
 
   return html_view_;
 }
@@ -18,8 +18,22 @@ class ConverterCmark final : public Converter {
   }
   std::string_view toHtml(std::string_view source) override;
 
+  // Feeds the pieces to the parser without joining them.
+  std::string_view toHtmlSegmented(const TextSegments &source) override;
+  std::string_view sourcepos() const override {
+    return sourcepos_;
+  }
+
  private:
   // Keeps the buffer alive until the next toHtml() call
   std::unique_ptr<char, decltype(&free)> html_owner_{ nullptr, &free };
   std::string_view html_view_;
+
+  // Output of a parallel (chunked) render, and its joined input
+  std::string html_chunked_;
+  std::string source_joined_;
+
+  // Output with data-sourcepos moved into the side table
+  std::string html_stripped_;
+  std::string sourcepos_;
 };
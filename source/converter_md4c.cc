@@ -11,7 +11,15 @@ extern "C" {
 #include <md4c-html.h>
 }
 
-std::string_view ConverterMd4c::toHtml(std::string_view source) {
+#include "markdown_chunker.h"
+#include "preview_config.h"
+
+namespace {
+
+// Below this size, splitting costs more than it saves
+constexpr std::size_t kMinChunkSize = 256 * 1024;
+
+std::string renderHtml(std::string_view source) {
   unsigned parser_flags = MD_FLAG_TABLES | MD_FLAG_STRIKETHROUGH | MD_FLAG_TASKLISTS |
                           MD_FLAG_PERMISSIVEURLAUTOLINKS | MD_FLAG_PERMISSIVEWWWAUTOLINKS |
                           MD_FLAG_UNDERLINE;
@@ -38,6 +46,22 @@ std::string_view ConverterMd4c::toHtml(std::string_view source) {
     buffer.clear();
   }
 
+  return buffer;
+}
+
+}  // namespace
+
+std::string_view ConverterMd4c::toHtml(std::string_view source) {
+  std::string buffer;
+
+  // Large documents: render top-level chunks in parallel
+  auto &cfg = PreviewConfig::instance();
+  int parallel_min_size = cfg.get(Settings::kMarkdownParallelMinSize);
+  if (parallel_min_size <= 0 || source.size() < static_cast<std::size_t>(parallel_min_size) ||
+      !MarkdownChunker::render(source, kMinChunkSize, renderHtml, false, buffer)) {
+    buffer = renderHtml(source);
+  }
+
   html_owner_ = std::make_unique<std::string>(std::move(buffer));
   html_view_ = std::string_view(html_owner_->data(), html_owner_->size());
 
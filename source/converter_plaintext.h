@@ -0,0 +1,75 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+#include "converter.h"
+
+// Renders text as preformatted blocks of a fixed number of lines.  Blocks use
+// content-visibility, so WebKit lays out only the ones near the viewport.
+class ConverterPlaintext final : public Converter {
+ public:
+  std::string_view id() const override {
+    return "plaintext";
+  }
+
+  std::string_view toHtml(std::string_view source) override {
+    html_.clear();
+    html_.reserve(source.size() + source.size() / 8 + 256);
+
+    std::size_t pos = 0;
+    while (pos < source.size()) {
+      // Find the end of the next block of lines
+      std::size_t end = pos;
+      std::size_t lines = 0;
+      while (end < source.size() && lines < kLinesPerBlock) {
+        const void *nl = std::memchr(source.data() + end, '\n', source.size() - end);
+        end = nl ? static_cast<const char *>(nl) - source.data() + 1 : source.size();
+        ++lines;
+      }
+
+      // The parser drops one newline right after <pre>; keep leading blank lines
+      html_ += "<pre class=\"plaintext\" style=\"contain-intrinsic-size: auto ";
+      html_ += std::to_string(lines * 6 / 5 + 1);
+      html_ += "em\">\n";
+      appendEscaped(source.substr(pos, end - pos));
+      html_ += "</pre>\n";
+      pos = end;
+    }
+    return html_;
+  }
+
+ private:
+  static constexpr std::size_t kLinesPerBlock = 500;
+
+  void appendEscaped(std::string_view text) {
+    std::size_t copied = 0;
+    for (std::size_t i = 0; i < text.size(); ++i) {
+      const char *entity = nullptr;
+      switch (text[i]) {
+        case '&':
+          entity = "&amp;";
+          break;
+        case '<':
+          entity = "&lt;";
+          break;
+        case '>':
+          entity = "&gt;";
+          break;
+        default:
+          continue;
+      }
+      html_.append(text.substr(copied, i - copied));
+      html_ += entity;
+      copied = i + 1;
+    }
+    html_.append(text.substr(copied));
+  }
+
+  std::string html_;
+};
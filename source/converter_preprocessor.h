@@ -3,11 +3,15 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cstring>
 #include <string>
 #include <string_view>
 #include <vector>
 
 #include "document_geany.h"
+#include "text_segments.h"
 #include "util/string_utils.h"
 
 class ConverterPreprocessor {
@@ -18,55 +22,76 @@ class ConverterPreprocessor {
     preprocess(doc);
   }
 
+  void setMaxIncomplete(std::size_t max_incomplete) noexcept {
+    max_incomplete_ = max_incomplete;
+  }
+
+  // Reuses the previous parse when the document still starts with the same
+  // header block, so edits in the body do not touch the headers.
   void preprocess(const Document &doc) {
-    headers_.clear();
-    type_.clear();
-    body_ = {};
-    splitDocument(doc);
+    TextSegments text = doc.segments();
+
+    if (!cached_region_.empty() && cached_max_incomplete_ == max_incomplete_ &&
+        text.matches(0, cached_region_)) {
+      useCache();
+      body_ = text.substr(cached_region_.size());
+      return;
+    }
+
+    // Headers are parsed from one contiguous view.  When the text is split
+    // early on, copy a bounded prefix and only copy everything if the header
+    // block runs past it.
+    std::string_view head = text.front();
+    if (!text.isContiguous() && head.size() < kHeadScanSize) {
+      head = text.prefix(kHeadScanSize, scratch_);
+    }
+    std::size_t region = splitDocument(head);
+    if (!headers_.empty() && region == head.size() && head.size() < text.size()) {
+      scratch_ = text.str();
+      head = scratch_;
+      region = splitDocument(head);
+    }
+
+    body_ = text.substr(region);
+    updateCache(head, region);
   }
 
   const std::vector<std::pair<std::string_view, std::string_view>> &headers() const noexcept {
     return headers_;
   }
-  std::string_view body() const noexcept {
+  // May be split in two; see Document::segments().
+  const TextSegments &body() const noexcept {
     return body_;
   }
   const std::string &type() const noexcept {
     return type_;
   }
 
-  std::string headersToHtml() const {
-    if (headers_.empty()) {
-      return {};
-    }
+  const std::string &headersToHtml() const noexcept {
+    return headers_html_;
+  }
 
-    std::string html;
-    html += "<div class=\"headers\">\n";
-    for (auto &[key, value] : headers_) {
-      bool incomplete = key.empty() || value.empty();
-      html += "  <div class=\"header-line";
-      if (incomplete) {
-        html += " incomplete";
+ private:
+  // ASCII case-insensitive comparison; b must be lowercase.
+  static constexpr bool equalsLower(std::string_view a, std::string_view b) noexcept {
+    if (a.size() != b.size()) {
+      return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+      char c = a[i];
+      if (c >= 'A' && c <= 'Z') {
+        c = static_cast<char>(c - 'A' + 'a');
+      }
+      if (c != b[i]) {
+        return false;
       }
-      html += "\">";
-
-      // Key
-      html += "<span class=\"header-key\">";
-      html += key.empty() ? "(missing key)" : StringUtils::escapeHtml(key);
-      html += "</span>: ";
-
-      // Value
-      html += "<span class=\"header-value\">";
-      html += value.empty() ? "&mdash;" : StringUtils::escapeHtml(value);
-      html += "</span>";
-
-      html += "</div>\n";
     }
-    html += "</div>\n";
-    return html;
+    return true;
   }
 
- private:
+  static constexpr std::array<std::string_view, 6> kProtocols = { "http", "https",  "file",
+                                                                  "ftp",  "mailto", "data" };
+
   static bool isValidHeaderKeyLine(std::string_view line, std::size_t colon_pos) {
     // Reject if starts with space/tab
     if (!line.empty() && (line.front() == ' ' || line.front() == '\t')) {
@@ -75,26 +100,20 @@ class ConverterPreprocessor {
 
     // Reject if key portion contains space/tab
     std::string_view key_part = line.substr(0, colon_pos);
-    if (key_part.find(' ') != std::string_view::npos ||
-        key_part.find('\t') != std::string_view::npos) {
+    if (key_part.find_first_of(" \t") != std::string_view::npos) {
       return false;
     }
 
-    // Lowercase for comparison
-    auto lower_key = StringUtils::toLower(key_part);
-
-    // Known protocols
-    static const std::vector<std::string> protocols = { "http", "https",  "file",
-                                                        "ftp",  "mailto", "data" };
-
     // Check char after colon
     char after_colon = (colon_pos + 1 < line.size()) ? line[colon_pos + 1] : '\0';
     char after_colon2 = (colon_pos + 2 < line.size()) ? line[colon_pos + 2] : '\0';
 
     // Reject known protocol + no space after colon
-    for (const auto &proto : protocols) {
-      if (lower_key == proto && after_colon != ' ' && after_colon != '\t') {
-        return false;
+    if (after_colon != ' ' && after_colon != '\t') {
+      for (auto proto : kProtocols) {
+        if (equalsLower(key_part, proto)) {
+          return false;
+        }
       }
     }
 
@@ -106,19 +125,30 @@ class ConverterPreprocessor {
     return true;
   }
 
-  void splitDocument(const Document &doc) {
-    std::string_view view = doc.textView();
+  // Returns the position of the first '\r' or '\n' at or after pos, or npos.
+  static std::size_t findLineEnd(std::string_view view, std::size_t pos) {
+    const char *begin = view.data() + pos;
+    std::size_t n = view.size() - pos;
+    const void *lf = std::memchr(begin, '\n', n);
+    std::size_t lf_len = lf ? static_cast<const char *>(lf) - begin : n;
+    const void *cr = std::memchr(begin, '\r', lf_len);
+    if (cr) {
+      return pos + (static_cast<const char *>(cr) - begin);
+    }
+    return lf ? pos + lf_len : std::string_view::npos;
+  }
+
+  // Parses the header block; returns its length including the blank line.
+  std::size_t splitDocument(std::string_view view) {
     std::size_t pos = 0;
     std::size_t incompleteCount = 0;
 
     headers_.clear();
     type_.clear();
-    body_ = {};
-    headers_.reserve(8);
 
     while (pos < view.size()) {
       // Find end of current line
-      std::size_t line_end = view.find_first_of("\r\n", pos);
+      std::size_t line_end = findLineEnd(view, pos);
       std::string_view line = (line_end == std::string_view::npos)
                                   ? view.substr(pos)
                                   : view.substr(pos, line_end - pos);
@@ -145,8 +175,7 @@ class ConverterPreprocessor {
           // First line is not a valid header → bail early
           headers_.clear();
           type_.clear();
-          body_ = view;
-          return;
+          return 0;
         }
         // Treat as incomplete: whole line is key, empty value
         headers_.emplace_back(StringUtils::trimWhitespaceView(line), std::string_view{});
@@ -157,12 +186,16 @@ class ConverterPreprocessor {
 
         if (k.empty() || v.empty()) {
           ++incompleteCount;
-        } else if (StringUtils::toLower(k) == "format" ||
-                   StringUtils::toLower(k) == "content-type") {
+        } else if (equalsLower(k, "format") || equalsLower(k, "content-type")) {
           // Take only MIME type before ';'
           std::string_view mime = v.substr(0, v.find(';'));
           mime = StringUtils::trimWhitespaceView(mime);
-          type_ = StringUtils::toLower(mime);
+          type_.assign(mime);
+          for (auto &c : type_) {
+            if (c >= 'A' && c <= 'Z') {
+              c = static_cast<char>(c - 'A' + 'a');
+            }
+          }
         }
         headers_.emplace_back(k, v);
       }
@@ -170,8 +203,7 @@ class ConverterPreprocessor {
       if (incompleteCount > max_incomplete_) {
         headers_.clear();
         type_.clear();
-        body_ = view;
-        return;
+        return 0;
       }
 
       // Advance to next line
@@ -189,13 +221,92 @@ class ConverterPreprocessor {
     }
 
     // Body is whatever remains
-    body_ = (pos < view.size()) ? view.substr(pos) : std::string_view{};
+    return std::min(pos, view.size());
+  }
+
+  // Remembers the header block as offsets into the region, plus its HTML.
+  void updateCache(std::string_view view, std::size_t region) {
+    cached_offsets_.clear();
+    cached_max_incomplete_ = max_incomplete_;
+
+    if (headers_.empty()) {
+      cached_region_.clear();
+      headers_html_.clear();
+      return;
+    }
+
+    // Header block that reached the end of the document: the next keystroke
+    // changes it anyway, so don't bother caching.  A trailing lone '\r' could
+    // still become part of a "\r\n" line break.
+    if (body_.empty() || view[region - 1] == '\r') {
+      cached_region_.clear();
+    } else {
+      cached_region_.assign(view.substr(0, region));
+    }
+
+    auto offset = [&](std::string_view sv) -> std::pair<std::size_t, std::size_t> {
+      return { sv.empty() ? 0 : static_cast<std::size_t>(sv.data() - view.data()), sv.size() };
+    };
+    for (auto &[k, v] : headers_) {
+      cached_offsets_.emplace_back(offset(k), offset(v));
+    }
+
+    renderHeaders();
+    if (!cached_region_.empty()) {
+      useCache();  // views into the copy outlive scratch_
+    }
+  }
+
+  // Points the headers into cached_region_.
+  void useCache() {
+    std::string_view region = cached_region_;
+    headers_.clear();
+    for (auto &[k, v] : cached_offsets_) {
+      headers_.emplace_back(region.substr(k.first, k.second), region.substr(v.first, v.second));
+    }
+  }
+
+  void renderHeaders() {
+    headers_html_.clear();
+    headers_html_ += "<div class=\"headers\">\n";
+    for (auto &[key, value] : headers_) {
+      bool incomplete = key.empty() || value.empty();
+      headers_html_ += "  <div class=\"header-line";
+      if (incomplete) {
+        headers_html_ += " incomplete";
+      }
+      headers_html_ += "\">";
+
+      // Key
+      headers_html_ += "<span class=\"header-key\">";
+      headers_html_ += key.empty() ? "(missing key)" : StringUtils::escapeHtml(key);
+      headers_html_ += "</span>: ";
+
+      // Value
+      headers_html_ += "<span class=\"header-value\">";
+      headers_html_ += value.empty() ? "&mdash;" : StringUtils::escapeHtml(value);
+      headers_html_ += "</span>";
+
+      headers_html_ += "</div>\n";
+    }
+    headers_html_ += "</div>\n";
   }
 
  private:
   std::vector<std::pair<std::string_view, std::string_view>> headers_;
   std::string type_;
-  std::string_view body_;
+  TextSegments body_;
+
+  // Contiguous copy of the start of a split text
+  static constexpr std::size_t kHeadScanSize = 64 * 1024;
+  std::string scratch_;
 
   std::size_t max_incomplete_ = 3;
+
+  // Parse cache, valid while the document starts with cached_region_
+  using Span = std::pair<std::size_t, std::size_t>;
+  std::string cached_region_;
+  std::vector<std::pair<Span, Span>> cached_offsets_;
+  std::size_t cached_max_incomplete_ = 0;
+  std::string headers_html_;
 };
@@ -4,90 +4,151 @@
 #include "converter_registrar.h"
 
 #include <algorithm>
-#include <filesystem>
 
-ConverterRegistrar::ConverterRegistrar() {
-  // prevent rehashing
-  alias_to_key_.reserve(std::size(converter_defs_) * 5);
+constexpr ConverterRegistrar::AliasTable ConverterRegistrar::buildAliasTable() {
+  AliasTable t;
 
-  for (const auto &def : converter_defs_) {
-    // Store factory for later use
-    factories_[def.key] = def.factory;
-
-    auto addAlias = [&](std::string_view raw, auto normalizer) {
-      auto alias = normalizer(raw);
-      if (!alias_to_key_.contains(alias)) {
-        alias_to_key_[alias] = def.key;
+  auto add = [&](std::string_view alias, std::size_t def) {
+    if (alias.empty()) {
+      return;
+    }
+    // First definition wins
+    for (std::size_t i = 0; i < t.count; ++i) {
+      if (equalsIgnoreCase(t.aliases[i], alias)) {
+        return;
+      }
+    }
+    t.aliases[t.count] = alias;
+    t.def_index[t.count] = static_cast<std::uint8_t>(def);
+    ++t.count;
+  };
+
+  for (std::size_t d = 0; d < std::size(converter_defs_); ++d) {
+    const auto &def = converter_defs_[d];
+    add(def.key, d);
+    add(def.filetype_name, d);
+    for (const char *ext : def.extensions) {
+      if (ext) {
+        add(std::string_view(ext).substr(1), d);  // without the leading dot
+      }
+    }
+    for (const char *type : def.mime_types) {
+      if (type) {
+        add(type, d);
       }
-    };
-
-    // Canonical key
-    addAlias(def.key, normalizeAlias);
-
-    // Geany filetype name
-    addAlias(def.filetype_name, normalizeAlias);
-
-    // Extensions
-    for (const auto &ext : def.extensions) {
-      addAlias(ext, normalizeExtension);
     }
+  }
 
-    // MIME types
-    for (const auto &type : def.mime_types) {
-      addAlias(type, normalizeAlias);
+  // Search for a seed that gives every alias its own slot
+  for (t.seed = 1;; ++t.seed) {
+    t.slots = {};
+    bool collision = false;
+    for (std::size_t i = 0; i < t.count && !collision; ++i) {
+      auto &slot = t.slots[hashAlias(t.aliases[i], t.seed) % kSlots];
+      collision = slot != 0;
+      slot = static_cast<std::uint8_t>(i + 1);
+    }
+    if (!collision) {
+      return t;
     }
   }
 }
 
-Converter *ConverterRegistrar::getConverter(const std::string &alias) const {
-  std::string key = getConverterKey(alias);
+constexpr ConverterRegistrar::AliasTable ConverterRegistrar::alias_table_ =
+    ConverterRegistrar::buildAliasTable();
+
+Converter *ConverterRegistrar::getConverter(std::string_view alias) const {
+  std::string_view key = getConverterKey(alias);
+  if (key.empty()) {
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(instances_mutex_);
+  auto &instances = instances_[std::this_thread::get_id()];
 
   // Check if instance already exists
-  auto it = instances_.find(key);
-  if (it != instances_.end()) {
+  auto it = instances.find(key);
+  if (it != instances.end()) {
     return it->second.get();
   }
 
-  // Create new instance if factory exists
-  auto fit = factories_.find(key);
-  if (fit != factories_.end()) {
-    auto instance = fit->second();
-    auto *ptr = instance.get();
-    instances_[key] = std::move(instance);
-    return ptr;
+  // Create new instance from the defining entry
+  for (const auto &def : converter_defs_) {
+    if (def.key == key) {
+      auto instance = def.factory();
+      auto *ptr = instance.get();
+      instances[key] = std::move(instance);
+      return ptr;
+    }
   }
 
   return nullptr;
 }
 
+std::vector<std::string> ConverterRegistrar::binaries() {
+  std::vector<std::string> result;
+  for (const auto &def : converter_defs_) {
+    if (def.binary && std::find(result.begin(), result.end(), def.binary) == result.end()) {
+      result.emplace_back(def.binary);
+    }
+  }
+  return result;
+}
+
+bool ConverterRegistrar::isExternal(std::string_view key) {
+  for (const auto &def : converter_defs_) {
+    if (def.key == key) {
+      return def.binary != nullptr;
+    }
+  }
+  return false;
+}
+
+void ConverterRegistrar::releaseConverters() const {
+  std::unordered_map<std::thread::id, InstanceMap> released;
+  {
+    std::lock_guard<std::mutex> lock(instances_mutex_);
+    released.swap(instances_);
+  }
+  // converters are destroyed outside the lock
+}
+
 Converter *ConverterRegistrar::getConverter(const Document &document) const {
   auto key = getConverterKey(document);
   return getConverter(key);
 }
 
-std::string ConverterRegistrar::getConverterKey(const std::string &alias) const {
-  auto it = alias_to_key_.find(normalizeAlias(alias));
-  if (it != alias_to_key_.end()) {
-    return it->second;
+std::string_view ConverterRegistrar::getConverterKey(std::string_view alias) const {
+  if (alias.empty()) {
+    return {};
   }
 
-  return {};
+  const auto &t = alias_table_;
+  std::uint8_t slot = t.slots[hashAlias(alias, t.seed) % kSlots];
+  if (slot == 0 || !equalsIgnoreCase(t.aliases[slot - 1], alias)) {
+    return {};
+  }
+  return converter_defs_[t.def_index[slot - 1]].key;
 }
 
-std::string ConverterRegistrar::getConverterKey(const Document &document) const {
-  // Try filetype name
-  auto it = alias_to_key_.find(normalizeAlias(document.filetypeName()));
-  if (it != alias_to_key_.end()) {
-    return it->second;
+std::string_view ConverterRegistrar::getConverterKey(const Document &document) const {
+  if (auto memo = document.converterKeyMemo()) {
+    return *memo;
   }
 
+  // Try filetype name
+  std::string_view key = getConverterKey(document.filetypeName());
+
   // Try extension
-  namespace fs = std::filesystem;
-  std::string ext = fs::path(document.filePath()).extension().string();
-  auto eit = alias_to_key_.find(normalizeExtension(ext));
-  if (eit != alias_to_key_.end()) {
-    return eit->second;
+  if (key.empty()) {
+    std::string_view path = document.filePath();
+    std::string_view name = path.substr(path.find_last_of('/') + 1);
+    auto dot = name.find_last_of('.');
+    if (dot != std::string_view::npos && dot > 0) {
+      key = getConverterKey(name.substr(dot + 1));
+    }
   }
 
-  return {};
+  document.setConverterKeyMemo(key);
+  return key;
 }
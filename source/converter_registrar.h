@@ -3,9 +3,14 @@
 
 #pragma once
 
-#include <functional>
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
@@ -14,8 +19,8 @@
 #include "converter_ftn2xml.h"
 #include "converter_pandoc.h"
 #include "converter_passthrough.h"
+#include "converter_plaintext.h"
 #include "document_geany.h"
-#include "util/string_utils.h"
 
 #if defined(HAVE_CMARK_GFM) || defined(HAVE_CMARK)
 #  include "converter_cmark.h"
@@ -25,144 +30,196 @@
 #  error "No Markdown converter backend available (libcmark-gfm, md4c, libcmark)"
 #endif
 
-using ConverterFactory = std::function<std::unique_ptr<Converter>()>;
+using ConverterFactory = std::unique_ptr<Converter> (*)();
 
 class ConverterRegistrar final {
  public:
-  ConverterRegistrar();
+  ConverterRegistrar() = default;
 
-  Converter *getConverter(const std::string &key) const;
+  // Returns the calling thread's instance for the key. Each thread gets its own
+  // converters, so the returned view stays valid until that thread converts again.
+  Converter *getConverter(std::string_view key) const;
   Converter *getConverter(const Document &document) const;
 
-  std::string getConverterKey(const std::string &alias) const;
-  std::string getConverterKey(const Document &document) const;
+  // Drops every thread's instances.  Only once no thread converts any more,
+  // e.g. after the worker pool has stopped.
+  void releaseConverters() const;
+
+  // External programs used by subprocess converters, without duplicates.
+  static std::vector<std::string> binaries();
+
+  // True if the key's converter runs an external program.
+  static bool isExternal(std::string_view key);
+
+  // Keys refer to static storage; lookups are case-insensitive and do not allocate.
+  std::string_view getConverterKey(std::string_view alias) const;
+  std::string_view getConverterKey(const Document &document) const;
 
  private:
   struct ConverterDef {
-    std::string key;
-    std::string filetype_name;
-    std::function<std::unique_ptr<Converter>()> factory;
-    std::vector<std::string> extensions;
-    std::vector<std::string> mime_types;
+    std::string_view key;
+    std::string_view filetype_name;
+    const char *binary;  // external program, if any
+    ConverterFactory factory;
+    // const char * rather than string_view: GCC 12 rejects value-initialized
+    // string_view elements of a static constexpr array in constant expressions.
+    std::array<const char *, 4> extensions;
+    std::array<const char *, 2> mime_types;
   };
 
   // clang-format off
-  inline static const ConverterDef converter_defs_[] = {
+  static constexpr ConverterDef converter_defs_[] = {
     // native
-    { "fountain", "Fountain",
-      [] { return std::make_unique<ConverterFtn2xml>(); },
+    { "fountain", "Fountain", nullptr,
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterFtn2xml>(); },
       { ".ftn", ".fountain" },
       { "text/fountain", "text/x-fountain" } },
 
-    { "html", "HTML",
-      [] { return std::make_unique<ConverterPassthrough>(); },
+    { "html", "HTML", nullptr,
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterPassthrough>(); },
       { ".htm", ".html", ".shtml", ".xhtml" },
       { "text/html", "application/xhtml+xml" } },
 
 #if defined(HAVE_CMARK_GFM) || defined(HAVE_CMARK)
-    { "markdown", "Markdown",
-      [] { return std::make_unique<ConverterCmark>(); },
+    { "markdown", "Markdown", nullptr,
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterCmark>(); },
       { ".md", ".markdown", ".txt" },
       { "text/markdown", "text/x-markdown" } },
 #elif defined(HAVE_MD4C)
-    { "markdown", "Markdown",
-      [] { return std::make_unique<ConverterMd4c>(); },
+    { "markdown", "Markdown", nullptr,
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterMd4c>(); },
       { ".md", ".markdown", ".txt" },
       { "text/markdown", "text/x-markdown" } },
 #endif
 
+    // not matched by extension; chosen by content sniffing or Content-Type
+    { "plaintext", "Plain Text", nullptr,
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterPlaintext>(); },
+      {},
+      { "text/plain" } },
+
     // subprocess
-    { "asciidoc", "Asciidoc",
-      [] { return std::make_unique<ConverterAsciidoctor>(); },
+    { "asciidoc", "Asciidoc", "asciidoctor",
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterAsciidoctor>(); },
       { ".asciidoc", ".adoc", ".asc" },
       { "text/asciidoc", "application/x-asciidoc" } },
 
     // pandoc
-    { "creole", "Creole Wiki",
-      [] { return std::make_unique<ConverterPandoc>("creole"); },
+    { "creole", "Creole Wiki", "pandoc",
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterPandoc>("creole"); },
       { ".creole" },
       { "text/x-creole" } },
 
-    { "docbook", "DocBook",
-      [] { return std::make_unique<ConverterPandoc>("docbook"); },
+    { "docbook", "DocBook", "pandoc",
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterPandoc>("docbook"); },
       { ".dbk" },
       { "application/docbook+xml" } },
 
-    { "dokuwiki", "DokuWiki",
-      [] { return std::make_unique<ConverterPandoc>("dokuwiki"); },
+    { "dokuwiki", "DokuWiki", "pandoc",
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterPandoc>("dokuwiki"); },
       { ".dokuwiki", ".wiki" },
       { "text/x-dokuwiki" } },
 
-    { "latex", "LaTeX",
-      [] { return std::make_unique<ConverterPandoc>("latex"); },
+    { "latex", "LaTeX", "pandoc",
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterPandoc>("latex"); },
       { ".tex", ".latex" },
       { "application/x-latex" } },
 
-    { "man", "Unix Manpage",
-      [] { return std::make_unique<ConverterPandoc>("man"); },
+    { "man", "Unix Manpage", "pandoc",
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterPandoc>("man"); },
       { ".man" },
       { "text/troff", "application/x-troff-man" } },
 
-    { "mediawiki", "MediaWiki",
-      [] { return std::make_unique<ConverterPandoc>("mediawiki"); },
+    { "mediawiki", "MediaWiki", "pandoc",
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterPandoc>("mediawiki"); },
       { ".mediawiki" },
       { "text/mediawiki" } },
 
-    { "org", "Org mode",
-      [] { return std::make_unique<ConverterPandoc>("org"); },
+    { "org", "Org mode", "pandoc",
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterPandoc>("org"); },
       { ".org" },
       { "text/x-org" } },
 
-    { "rst", "reStructuredText",
-      [] { return std::make_unique<ConverterPandoc>("rst"); },
+    { "rst", "reStructuredText", "pandoc",
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterPandoc>("rst"); },
       { ".rst" },
       { "text/x-rst" } },
 
-    { "rtf", "Rich Text Format",
-      [] { return std::make_unique<ConverterPandoc>("rtf"); },
+    { "rtf", "Rich Text Format", "pandoc",
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterPandoc>("rtf"); },
       { ".rtf" },
       { "application/rtf", "text/rtf" } },
 
-    { "t2t", "Txt2tags",
-      [] { return std::make_unique<ConverterPandoc>("t2t"); },
+    { "t2t", "Txt2tags", "pandoc",
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterPandoc>("t2t"); },
       { ".t2t" },
       { "text/x-txt2tags" } },
 
-    { "textile", "Textile",
-      [] { return std::make_unique<ConverterPandoc>("textile"); },
+    { "textile", "Textile", "pandoc",
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterPandoc>("textile"); },
       { ".textile" },
       { "text/textile" } },
 
-    { "tikiwiki", "TikiWiki",
-      [] { return std::make_unique<ConverterPandoc>("tikiwiki"); },
+    { "tikiwiki", "TikiWiki", "pandoc",
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterPandoc>("tikiwiki"); },
       { ".tiki", ".tikiwiki" },
       { "text/x-tikiwiki" } },
 
-    { "twiki", "TWiki",
-      [] { return std::make_unique<ConverterPandoc>("twiki"); },
+    { "twiki", "TWiki", "pandoc",
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterPandoc>("twiki"); },
       { ".twiki" },
       { "text/x-twiki" } },
 
-    { "vimwiki", "Vimwiki",
-      [] { return std::make_unique<ConverterPandoc>("vimwiki"); },
+    { "vimwiki", "Vimwiki", "pandoc",
+      []() -> std::unique_ptr<Converter> { return std::make_unique<ConverterPandoc>("vimwiki"); },
       { ".vw", ".vimwiki" },
       { "text/x-vimwiki" } }
   };
   // clang-format on
 
  private:
-  std::unordered_map<std::string, std::string> alias_to_key_;
-  std::unordered_map<std::string, ConverterFactory> factories_;
-  mutable std::unordered_map<std::string, std::unique_ptr<Converter>> instances_;
+  // Perfect hash over every alias (key, filetype name, extension without the
+  // dot, MIME type), built at compile time.  Each alias hashes to its own slot.
+  static constexpr std::size_t kMaxAliases = 128;
+  static constexpr std::size_t kSlots = 4096;
+
+  struct AliasTable {
+    std::array<std::string_view, kMaxAliases> aliases{};
+    std::array<std::uint8_t, kMaxAliases> def_index{};
+    std::array<std::uint8_t, kSlots> slots{};  // alias index + 1; 0 = empty
+    std::size_t count = 0;
+    std::uint32_t seed = 0;
+  };
 
-  static std::string normalizeAlias(std::string_view s) {
-    return StringUtils::toLower(s);
+  static constexpr char foldCase(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
   }
 
-  static std::string normalizeExtension(std::string_view ext) {
-    if (!ext.empty() && ext.front() == '.') {
-      ext.remove_prefix(1);
+  static constexpr bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) {
+      return false;
+    }
+    for (std::size_t i = 0; i < a.size(); ++i) {
+      if (foldCase(a[i]) != foldCase(b[i])) {
+        return false;
+      }
     }
-    return StringUtils::toLower(ext);
+    return true;
   }
+
+  static constexpr std::uint32_t hashAlias(std::string_view s, std::uint32_t seed) {
+    std::uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+    for (char c : s) {
+      h ^= static_cast<unsigned char>(foldCase(c));
+      h *= 16777619u;
+    }
+    return h ^ (h >> 15);
+  }
+
+  static constexpr AliasTable buildAliasTable();
+  static const AliasTable alias_table_;
+
+  using InstanceMap = std::unordered_map<std::string_view, std::unique_ptr<Converter>>;
+  mutable std::mutex instances_mutex_;
+  mutable std::unordered_map<std::thread::id, InstanceMap> instances_;
 };
@@ -19,7 +19,20 @@ std::vector<std::string> ConverterSubprocess::buildCommandArgs() const {
 }
 
 std::string_view ConverterSubprocess::toHtml(std::string_view source) {
-  GMainLoop *loop = g_main_loop_new(nullptr, false);
+  // Off the UI thread, wait on a private context so the global one is untouched.
+  GMainContext *context = nullptr;
+  if (!g_main_context_is_owner(g_main_context_default())) {
+    context = g_main_context_new();
+    g_main_context_push_thread_default(context);
+  }
+  auto releaseContext = [context]() {
+    if (context) {
+      g_main_context_pop_thread_default(context);
+      g_main_context_unref(context);
+    }
+  };
+
+  GMainLoop *loop = g_main_loop_new(context, false);
 
   Subprocess runner;
   Subprocess::Result result;
@@ -29,6 +42,7 @@ std::string_view ConverterSubprocess::toHtml(std::string_view source) {
         g_main_loop_quit(loop);
       })) {
     g_main_loop_unref(loop);
+    releaseContext();
     html_ =
         "<strong>Conversion failed</strong><br/>"
         "<pre style=\"white-space: pre-wrap;\">"
@@ -39,8 +53,11 @@ std::string_view ConverterSubprocess::toHtml(std::string_view source) {
 
   g_main_loop_run(loop);
   g_main_loop_unref(loop);
+  releaseContext();
 
-  if (result.exit_status == 0) {
+  if (result.cancelled) {
+    html_ = "<strong>Conversion cancelled</strong>";
+  } else if (result.exit_status == 0) {
     html_ = std::move(result.stdout_data);
   } else {
     html_ =
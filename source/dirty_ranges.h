@@ -0,0 +1,122 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// One contiguous change since the last render.  position and inserted are in
+// current text coordinates; deleted is the length of the text it replaced.
+struct DirtyRange {
+  std::size_t position = 0;
+  std::size_t deleted = 0;
+  std::size_t inserted = 0;
+  long lines_added = 0;
+};
+
+// Coalesced, sorted, non-overlapping edits since the last render.  A set marked
+// whole() means the extent of the changes is unknown: treat all text as changed.
+class DirtyRanges {
+ public:
+  static DirtyRanges all() {
+    DirtyRanges r;
+    r.whole_ = true;
+    return r;
+  }
+
+  bool whole() const noexcept {
+    return whole_;
+  }
+  bool empty() const noexcept {
+    return !whole_ && ranges_.empty();
+  }
+  const std::vector<DirtyRange> &ranges() const noexcept {
+    return ranges_;
+  }
+
+  // Net lines added across all ranges.
+  long linesAdded() const noexcept {
+    long n = 0;
+    for (const auto &r : ranges_) {
+      n += r.lines_added;
+    }
+    return n;
+  }
+
+  // Records that `deleted` bytes at position were replaced by `inserted` bytes.
+  void add(std::size_t position, std::size_t deleted, std::size_t inserted, long lines_added) {
+    if (whole_) {
+      return;
+    }
+
+    // Union of the edit and every range it touches, in pre-edit coordinates
+    std::size_t begin = position;
+    std::size_t end = position + deleted;
+    std::size_t merged_inserted = 0;
+    std::size_t merged_deleted = 0;
+    long merged_lines = lines_added;
+
+    auto first = std::lower_bound(
+        ranges_.begin(), ranges_.end(), position,
+        [](const DirtyRange &r, std::size_t pos) { return r.position + r.inserted < pos; }
+    );
+    auto last = first;
+    while (last != ranges_.end() && last->position <= end) {
+      begin = std::min(begin, last->position);
+      end = std::max(end, last->position + last->inserted);
+      merged_inserted += last->inserted;
+      merged_deleted += last->deleted;
+      merged_lines += last->lines_added;
+      ++last;
+    }
+
+    // Shift the ranges after the edit
+    const std::ptrdiff_t shift =
+        static_cast<std::ptrdiff_t>(inserted) - static_cast<std::ptrdiff_t>(deleted);
+    for (auto it = last; it != ranges_.end(); ++it) {
+      it->position = static_cast<std::size_t>(static_cast<std::ptrdiff_t>(it->position) + shift);
+    }
+
+    DirtyRange merged;
+    merged.position = begin;
+    merged.deleted = (end - begin) - merged_inserted + merged_deleted;
+    merged.inserted = (end - begin) - deleted + inserted;
+    merged.lines_added = merged_lines;
+
+    auto pos = ranges_.erase(first, last);
+    ranges_.insert(pos, merged);
+
+    // Many scattered edits: one span is as useful and stays cheap
+    if (ranges_.size() > kMaxRanges) {
+      collapse();
+    }
+  }
+
+  void markAll() noexcept {
+    whole_ = true;
+    ranges_.clear();
+  }
+
+ private:
+  static constexpr std::size_t kMaxRanges = 64;
+
+  void collapse() {
+    DirtyRange span;
+    span.position = ranges_.front().position;
+    std::size_t end = ranges_.back().position + ranges_.back().inserted;
+    std::size_t inserted = 0, deleted = 0;
+    for (const auto &r : ranges_) {
+      inserted += r.inserted;
+      deleted += r.deleted;
+      span.lines_added += r.lines_added;
+    }
+    span.inserted = end - span.position;
+    span.deleted = span.inserted - inserted + deleted;
+    ranges_.assign(1, span);
+  }
+
+  std::vector<DirtyRange> ranges_;
+  bool whole_ = false;
+};
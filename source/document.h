@@ -4,9 +4,17 @@
 #pragma once
 
 #include <cstddef>  // size_t
+#include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
 #include <string_view>
 
+#include "block_hashes.h"
+#include "dirty_ranges.h"
+#include "render_context.h"
+#include "text_segments.h"
+
 class Document {
  public:
   virtual ~Document() = default;
@@ -15,12 +23,32 @@ class Document {
   virtual std::string_view textView() const = 0;
   virtual std::string text() const = 0;
 
+  // Text without requiring it to be contiguous; backends with a gap buffer
+  // return both halves instead of closing the gap.
+  virtual TextSegments segments() const {
+    return textView();
+  }
+
   virtual const std::string &filePath() const = 0;
   virtual const std::string &filetypeName() const = 0;
   virtual const std::string &encodingName() const = 0;
 
+  // Changes whenever the text does and is never reused, even by another
+  // document; 0 if the backend does not track edits.  Cheaper to compare than
+  // computeHash(), but different generations may still hold the same text.
+  virtual std::uint64_t textGeneration() const {
+    return 0;
+  }
+
   virtual size_t computeHash() const {
-    return std::hash<std::string_view>{}(textView());
+    return static_cast<size_t>(blockHashes().digest());
+  }
+
+  // Per-block hashes of the text.  Rehashed in full here; backends that track
+  // edits update only the changed blocks.
+  virtual const BlockHashes &blockHashes() const {
+    block_hashes_.rebuild(segments());
+    return block_hashes_;
   }
 
   // Render tracking (shared across backends)
@@ -31,6 +59,31 @@ class Document {
     last_render_hash_ = hash;
   }
 
+  // Edits since the last render; whole() if the backend cannot tell
+  virtual DirtyRanges dirtyRanges() const {
+    return DirtyRanges::all();
+  }
+  virtual void resetDirtyRanges() const {}
+
+  // Memoized per-document values; fresh for each object unless the backend
+  // shares them between objects of the same document
+  RenderContext &renderContext() const {
+    if (!context_) {
+      context_ = std::make_shared<RenderContext>();
+    }
+    return *context_;
+  }
+
+  // Converter key resolved by ConverterRegistrar (refers to static storage)
+  std::optional<std::string_view> converterKeyMemo() const {
+    return renderContext().converter_key;
+  }
+  void setConverterKeyMemo(std::string_view key) const {
+    renderContext().converter_key = key;
+  }
+
  protected:
   size_t last_render_hash_ = 0;
+  mutable std::shared_ptr<RenderContext> context_;
+  mutable BlockHashes block_hashes_;
 };
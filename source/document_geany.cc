@@ -3,14 +3,15 @@
 
 #include "document_geany.h"
 
-#include <functional>  // std::hash
+#include <algorithm>
 #include <string>
+#include <unordered_map>
 
 #include <Scintilla.h>
 #include <geany/document.h>
 
 DocumentGeany::DocumentGeany(GeanyDocument *geany_document) : geany_document_(geany_document) {
-  updateFilePath().updateFiletypeName().updateEncodingName();
+  context_ = contextFor(geany_document);
 }
 
 std::string_view DocumentGeany::textView() const {
@@ -35,34 +36,222 @@ std::string_view DocumentGeany::textView() const {
   return std::string_view(buffer_ptr, length);
 }
 
-std::string DocumentGeany::text() const {
-  auto view = textView();
-  return std::string{ view };
+TextSegments DocumentGeany::segments() const {
+  if (!geany_document_ || !geany_document_->editor || !geany_document_->editor->sci) {
+    return {};
+  }
+
+  ScintillaObject *sci = geany_document_->editor->sci;
+  auto length = static_cast<sptr_t>(scintilla_send_message(sci, SCI_GETLENGTH, 0, 0));
+  auto gap = static_cast<sptr_t>(scintilla_send_message(sci, SCI_GETGAPPOSITION, 0, 0));
+  gap = std::clamp<sptr_t>(gap, 0, length);
+
+  // A range that ends at or starts after the gap is returned in place
+  auto range = [sci](sptr_t pos, sptr_t len) -> std::string_view {
+    if (len <= 0) {
+      return {};
+    }
+    auto *ptr = reinterpret_cast<const char *>(
+        scintilla_send_message(sci, SCI_GETRANGEPOINTER, static_cast<uptr_t>(pos), len)
+    );
+    return ptr ? std::string_view(ptr, static_cast<size_t>(len)) : std::string_view{};
+  };
+
+  return { range(0, gap), range(gap, length - gap) };
+}
+
+namespace {
+// Last snapshot per document id, used as the base for the next one, and the
+// edits made since it was taken
+struct SnapshotEntry {
+  std::shared_ptr<const DocumentSnapshot> snapshot;
+  DirtyRanges edits;
+};
+
+std::unordered_map<unsigned, SnapshotEntry> &lastSnapshots() {
+  static std::unordered_map<unsigned, SnapshotEntry> snapshots;
+  return snapshots;
+}
+
+// Edits since the last render per document id; no entry = never rendered
+std::unordered_map<unsigned, DirtyRanges> &dirtyStore() {
+  static std::unordered_map<unsigned, DirtyRanges> store;
+  return store;
+}
+
+// Render context per document id, with the Geany strings it was built from.
+// Geany replaces these strings when they change, so a different pointer
+// catches changes that come without a signal (e.g. Set Encoding).
+struct ContextEntry {
+  std::shared_ptr<RenderContext> context;
+  const void *real_path = nullptr;
+  const void *file_type = nullptr;
+  const void *encoding = nullptr;
+};
+
+std::unordered_map<unsigned, ContextEntry> &contextStore() {
+  static std::unordered_map<unsigned, ContextEntry> store;
+  return store;
+}
+
+// Text generation per document id, from one sequence shared by all documents
+std::uint64_t nextGeneration() {
+  static std::uint64_t counter = 0;
+  return ++counter;
+}
+
+std::unordered_map<unsigned, std::uint64_t> &generationStore() {
+  static std::unordered_map<unsigned, std::uint64_t> store;
+  return store;
+}
+
+// Block hashes per document id, the edits they have not seen yet and the
+// text generation they are up to date with
+struct HashState {
+  BlockHashes hashes;
+  DirtyRanges pending = DirtyRanges::all();
+  std::uint64_t generation = 0;
+};
+
+std::unordered_map<unsigned, HashState> &hashStore() {
+  static std::unordered_map<unsigned, HashState> store;
+  return store;
+}
+}  // namespace
+
+std::uint64_t DocumentGeany::textGeneration() const {
+  if (!geany_document_) {
+    return 0;
+  }
+
+  auto [it, inserted] = generationStore().try_emplace(geany_document_->id);
+  if (inserted) {
+    it->second = nextGeneration();
+  }
+  return it->second;
+}
+
+const BlockHashes &DocumentGeany::blockHashes() const {
+  if (!geany_document_) {
+    return Document::blockHashes();
+  }
+
+  // Not even the text pointers are read until the text changes
+  auto &state = hashStore()[geany_document_->id];
+  std::uint64_t generation = textGeneration();
+  if (state.generation != generation) {
+    state.hashes.update(segments(), state.pending);
+    state.pending = DirtyRanges{};
+    state.generation = generation;
+  }
+  return state.hashes;
 }
 
-DocumentGeany &DocumentGeany::updateFilePath() {
-  if (geany_document_ && geany_document_->real_path) {
-    file_name_ = geany_document_->real_path;
-  } else {
-    file_name_.clear();
+DirtyRanges DocumentGeany::dirtyRanges() const {
+  if (!geany_document_) {
+    return DirtyRanges::all();
   }
-  return *this;
+  auto &store = dirtyStore();
+  auto it = store.find(geany_document_->id);
+  return it != store.end() ? it->second : DirtyRanges::all();
 }
 
-DocumentGeany &DocumentGeany::updateFiletypeName() {
-  if (geany_document_ && geany_document_->file_type && geany_document_->file_type->name) {
-    filetype_name_ = geany_document_->file_type->name;
-  } else {
-    filetype_name_.clear();
+void DocumentGeany::resetDirtyRanges() const {
+  if (geany_document_) {
+    dirtyStore()[geany_document_->id] = DirtyRanges{};
   }
-  return *this;
 }
 
-DocumentGeany &DocumentGeany::updateEncodingName() {
-  if (geany_document_ && geany_document_->encoding) {
-    encoding_name_ = geany_document_->encoding;
-  } else {
-    encoding_name_.clear();
+void DocumentGeany::recordChange(
+    GeanyDocument *geany_document,
+    std::size_t position,
+    std::size_t deleted,
+    std::size_t inserted,
+    long lines_added
+) {
+  if (!geany_document) {
+    return;
   }
-  return *this;
+  generationStore()[geany_document->id] = nextGeneration();
+
+  auto &store = dirtyStore();
+  auto it = store.find(geany_document->id);
+  if (it != store.end()) {
+    it->second.add(position, deleted, inserted, lines_added);
+  }
+
+  auto &hashes = hashStore();
+  auto hit = hashes.find(geany_document->id);
+  if (hit != hashes.end()) {
+    hit->second.pending.add(position, deleted, inserted, lines_added);
+  }
+
+  auto &snapshots = lastSnapshots();
+  auto sit = snapshots.find(geany_document->id);
+  if (sit != snapshots.end()) {
+    sit->second.edits.add(position, deleted, inserted, lines_added);
+  }
+}
+
+std::shared_ptr<const DocumentSnapshot> DocumentGeany::snapshot() const {
+  if (!geany_document_) {
+    return DocumentSnapshot::capture(*this);
+  }
+
+  auto &entry = lastSnapshots()[geany_document_->id];
+  entry.snapshot = DocumentSnapshot::capture(*this, entry.snapshot, entry.edits);
+  entry.edits = DirtyRanges{};
+  return entry.snapshot;
+}
+
+std::shared_ptr<RenderContext> DocumentGeany::contextFor(GeanyDocument *geany_document) {
+  if (!geany_document) {
+    return std::make_shared<RenderContext>();
+  }
+
+  auto &entry = contextStore()[geany_document->id];
+  if (entry.context && entry.real_path == geany_document->real_path &&
+      entry.file_type == geany_document->file_type && entry.encoding == geany_document->encoding) {
+    return entry.context;
+  }
+
+  auto context = std::make_shared<RenderContext>();
+  if (geany_document->real_path) {
+    context->file_path = geany_document->real_path;
+  }
+  if (geany_document->file_type && geany_document->file_type->name) {
+    context->filetype_name = geany_document->file_type->name;
+  }
+  if (geany_document->encoding) {
+    context->encoding_name = geany_document->encoding;
+  }
+
+  entry = { context, geany_document->real_path, geany_document->file_type,
+            geany_document->encoding };
+  return context;
+}
+
+void DocumentGeany::invalidate(GeanyDocument *geany_document) {
+  if (geany_document) {
+    contextStore().erase(geany_document->id);
+  }
+}
+
+void DocumentGeany::invalidateAll() {
+  contextStore().clear();
+}
+
+void DocumentGeany::forget(GeanyDocument *geany_document) {
+  if (geany_document) {
+    contextStore().erase(geany_document->id);
+    lastSnapshots().erase(geany_document->id);
+    dirtyStore().erase(geany_document->id);
+    hashStore().erase(geany_document->id);
+    generationStore().erase(geany_document->id);
+  }
+}
+
+std::string DocumentGeany::text() const {
+  auto view = textView();
+  return std::string{ view };
 }
@@ -3,10 +3,13 @@
 
 #pragma once
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <string_view>
 
 #include "document.h"
+#include "document_snapshot.h"
 
 struct GeanyDocument;
 
@@ -17,23 +20,52 @@ class DocumentGeany final : public Document {
   std::string_view textView() const override;
   std::string text() const override;
 
+  // Reads both sides of Scintilla's gap; textView() moves the gap to the end.
+  TextSegments segments() const override;
+
   const std::string &filePath() const override {
-    return file_name_;
+    return context_->file_path;
   }
   const std::string &filetypeName() const override {
-    return filetype_name_;
+    return context_->filetype_name;
   }
   const std::string &encodingName() const override {
-    return encoding_name_;
+    return context_->encoding_name;
   }
 
-  DocumentGeany &updateFilePath();
-  DocumentGeany &updateFiletypeName();
-  DocumentGeany &updateEncodingName();
+  // Bumped by recordChange()
+  std::uint64_t textGeneration() const override;
+
+  // Updated from the edits recorded since the last call.
+  const BlockHashes &blockHashes() const override;
+
+  DirtyRanges dirtyRanges() const override;
+  void resetDirtyRanges() const override;
+
+  // Immutable copy for other threads; shares unchanged chunks with the
+  // previous snapshot of the same document.  Main thread only.
+  std::shared_ptr<const DocumentSnapshot> snapshot() const;
+
+  // Fed from SCN_MODIFIED text insertions and deletions only; other
+  // modifications (styling, markers, indicators) leave the text as it was.
+  static void recordChange(
+      GeanyDocument *geany_document,
+      std::size_t position,
+      std::size_t deleted,
+      std::size_t inserted,
+      long lines_added
+  );
+
+  // Drops per-document state when the document is closed.
+  static void forget(GeanyDocument *geany_document);
+
+  // Rebuilds the shared render context on next use, e.g. after a save,
+  // filetype change or reload.  invalidateAll() is for config changes.
+  static void invalidate(GeanyDocument *geany_document);
+  static void invalidateAll();
 
  private:
+  static std::shared_ptr<RenderContext> contextFor(GeanyDocument *geany_document);
+
   GeanyDocument *geany_document_;
-  std::string file_name_;
-  std::string filetype_name_;
-  std::string encoding_name_;
 };
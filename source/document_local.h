@@ -6,6 +6,7 @@
 #include "document.h"
 
 #include <filesystem>
+#include <memory>
 #include <string>
 
 #include "util/file_utils.h"
@@ -28,14 +29,38 @@ class DocumentLocal final : public Document {
     }
   }
 
+  // Uses contents already loaded elsewhere, e.g. mapped on a worker thread.
+  DocumentLocal(
+      const std::filesystem::path &path,
+      std::shared_ptr<const FileUtils::MappedFile> contents
+  )
+      : DocumentLocal(path) {
+    file_ = std::move(contents);
+  }
+
+  // Maps the file; may be called off the UI thread.
+  static std::shared_ptr<const FileUtils::MappedFile>
+  load(const std::filesystem::path &path, bool prefetch = false) {
+    auto file = std::make_shared<FileUtils::MappedFile>(path);
+    if (prefetch) {
+      file->prefetch();
+    }
+    return file;
+  }
+
+  // Reads the file into memory.  For workers that hold the contents while
+  // the file may be truncated, which would raise SIGBUS on a mapping.
+  static std::shared_ptr<const FileUtils::MappedFile> read(const std::filesystem::path &path) {
+    return std::make_shared<FileUtils::MappedFile>(path, false);
+  }
+
   std::string_view textView() const override {
     ensureLoaded();
-    return text_cache_;
+    return file_->view();
   }
 
   std::string text() const override {
-    ensureLoaded();
-    return text_cache_;
+    return std::string{ textView() };
   }
 
   const std::string &filePath() const override {
@@ -52,22 +77,15 @@ class DocumentLocal final : public Document {
 
  private:
   void ensureLoaded() const {
-    if (loaded_) {
-      return;
-    }
-    loaded_ = true;
-
-    if (file_path_.empty()) {
-      text_cache_.clear();
+    if (file_) {
       return;
     }
-
-    text_cache_ = FileUtils::readFileToString(file_path_);
+    file_ = file_path_.empty() ? std::make_shared<const FileUtils::MappedFile>()
+                               : load(file_path_);
   }
 
   std::string file_path_;
   std::string filetype_name_;
   std::string encoding_name_;
-  mutable std::string text_cache_;
-  mutable bool loaded_ = false;
+  mutable std::shared_ptr<const FileUtils::MappedFile> file_;
 };
@@ -0,0 +1,166 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "document_snapshot.h"
+
+std::shared_ptr<const DocumentSnapshot> DocumentSnapshot::capture(
+    const Document &doc,
+    const std::shared_ptr<const DocumentSnapshot> &previous,
+    const DirtyRanges &edits
+) {
+  auto snap = std::shared_ptr<DocumentSnapshot>(new DocumentSnapshot);
+  snap->file_path_ = doc.filePath();
+  snap->filetype_name_ = doc.filetypeName();
+  snap->encoding_name_ = doc.encodingName();
+  snap->dirty_ = doc.dirtyRanges();
+  snap->text_generation_ = doc.textGeneration();
+  if (auto key = doc.converterKeyMemo()) {
+    snap->setConverterKeyMemo(*key);
+  }
+
+  // Read through segments so a Geany document keeps its gap where it is
+  TextSegments text = doc.segments();
+  snap->size_ = text.size();
+
+  // Count the old chunks that are unchanged at the start and the end of the text
+  std::size_t head = 0, head_bytes = 0;
+  std::size_t tail = 0, tail_bytes = 0;
+  const std::vector<Chunk> *old = previous ? &previous->chunks_ : nullptr;
+  if (old) {
+    // Same generation: not edited since, whatever edits says
+    bool unchanged = snap->text_generation_ != 0 &&
+                     snap->text_generation_ == previous->text_generation_;
+    if (!previous->keptByEdits(
+            unchanged ? DirtyRanges{} : edits, text.size(), head, head_bytes, tail, tail_bytes
+        )) {
+      previous->keptByText(text, head, head_bytes, tail, tail_bytes);
+    }
+
+    // Fold a small changed region into a neighbour so chunks don't fragment
+    std::size_t middle = text.size() - head_bytes - tail_bytes;
+    if (middle > 0 && middle < kChunkSize / 4) {
+      if (tail > 0) {
+        --tail;
+        tail_bytes -= (*old)[old->size() - 1 - tail]->size();
+      } else if (head > 0) {
+        --head;
+        head_bytes -= (*old)[head]->size();
+      }
+    }
+  }
+
+  std::size_t middle = text.size() - head_bytes - tail_bytes;
+  std::size_t pieces = (middle + kChunkSize - 1) / kChunkSize;
+  snap->chunks_.reserve(head + pieces + tail);
+
+  for (std::size_t i = 0; i < head; ++i) {
+    snap->chunks_.push_back((*old)[i]);
+  }
+
+  // Copy the changed region in evenly sized pieces
+  std::size_t pos = head_bytes;
+  for (std::size_t i = 0; i < pieces; ++i) {
+    std::size_t len = (middle - (pos - head_bytes)) / (pieces - i);
+    snap->chunks_.push_back(std::make_shared<const std::string>(text.substr(pos, len).str()));
+    pos += len;
+  }
+
+  for (std::size_t i = old ? old->size() - tail : 0; old && i < old->size(); ++i) {
+    snap->chunks_.push_back((*old)[i]);
+  }
+
+  return snap;
+}
+
+bool DocumentSnapshot::keptByEdits(
+    const DirtyRanges &edits,
+    std::size_t size,
+    std::size_t &head,
+    std::size_t &head_bytes,
+    std::size_t &tail,
+    std::size_t &tail_bytes
+) const {
+  if (edits.whole()) {
+    return false;
+  }
+
+  // Edited span in current coordinates; before and after it the text is as it was
+  const auto &ranges = edits.ranges();
+  std::ptrdiff_t delta = 0;
+  for (const auto &r : ranges) {
+    delta += static_cast<std::ptrdiff_t>(r.inserted) - static_cast<std::ptrdiff_t>(r.deleted);
+  }
+  if (static_cast<std::ptrdiff_t>(size_) + delta != static_cast<std::ptrdiff_t>(size)) {
+    return false;
+  }
+
+  std::size_t keep_before = size;
+  std::size_t keep_after = 0;
+  if (!ranges.empty()) {
+    keep_before = ranges.front().position;
+    std::size_t end = ranges.back().position + ranges.back().inserted;
+    if (keep_before > size || end > size) {
+      return false;
+    }
+    keep_after = size - end;
+  }
+
+  while (head < chunks_.size() && head_bytes + chunks_[head]->size() <= keep_before) {
+    head_bytes += chunks_[head++]->size();
+  }
+  while (tail < chunks_.size() - head) {
+    std::size_t len = chunks_[chunks_.size() - 1 - tail]->size();
+    if (tail_bytes + len > keep_after) {
+      break;
+    }
+    tail_bytes += len;
+    ++tail;
+  }
+  return true;
+}
+
+void DocumentSnapshot::keptByText(
+    const TextSegments &text,
+    std::size_t &head,
+    std::size_t &head_bytes,
+    std::size_t &tail,
+    std::size_t &tail_bytes
+) const {
+  head = head_bytes = tail = tail_bytes = 0;
+  while (head < chunks_.size()) {
+    const auto &c = *chunks_[head];
+    if (!text.matches(head_bytes, c)) {
+      break;
+    }
+    head_bytes += c.size();
+    ++head;
+  }
+
+  while (tail < chunks_.size() - head) {
+    const auto &c = *chunks_[chunks_.size() - 1 - tail];
+    if (head_bytes + tail_bytes + c.size() > text.size() ||
+        !text.matches(text.size() - tail_bytes - c.size(), c)) {
+      break;
+    }
+    tail_bytes += c.size();
+    ++tail;
+  }
+}
+
+std::string_view DocumentSnapshot::textView() const {
+  if (chunks_.size() == 1) {
+    return *chunks_.front();
+  }
+
+  std::call_once(flatten_once_, [this] {
+    flat_.reserve(size_);
+    for (const auto &c : chunks_) {
+      flat_ += *c;
+    }
+  });
+  return flat_;
+}
+
+std::string DocumentSnapshot::text() const {
+  return std::string{ textView() };
+}
@@ -0,0 +1,100 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "document.h"
+
+// Immutable copy of a document that can be handed to other threads.
+//
+// Text is held as a list of shared chunks.  A snapshot taken with a previous
+// snapshot of the same document reuses every chunk that is unchanged at the
+// start or end of the text, so only the chunks around an edit are copied.
+// Given the edits made since the previous snapshot, the unchanged chunks are
+// found from their sizes alone; otherwise they are compared with the text.
+class DocumentSnapshot final : public Document {
+ public:
+  using Chunk = std::shared_ptr<const std::string>;
+
+  // Captures doc, sharing unchanged chunks with previous (may be null).
+  // edits are the changes to doc since previous was taken; all() if unknown.
+  static std::shared_ptr<const DocumentSnapshot> capture(
+      const Document &doc,
+      const std::shared_ptr<const DocumentSnapshot> &previous = nullptr,
+      const DirtyRanges &edits = DirtyRanges::all()
+  );
+
+  // Flattened on first use; chunks() avoids the copy.
+  std::string_view textView() const override;
+  std::string text() const override;
+
+  const std::string &filePath() const override {
+    return file_path_;
+  }
+  const std::string &filetypeName() const override {
+    return filetype_name_;
+  }
+  const std::string &encodingName() const override {
+    return encoding_name_;
+  }
+
+  // Edits recorded on the source document when the snapshot was taken
+  DirtyRanges dirtyRanges() const override {
+    return dirty_;
+  }
+  // The source document's, when the snapshot was taken
+  std::uint64_t textGeneration() const override {
+    return text_generation_;
+  }
+
+  const std::vector<Chunk> &chunks() const noexcept {
+    return chunks_;
+  }
+  std::size_t size() const noexcept {
+    return size_;
+  }
+
+ private:
+  DocumentSnapshot() = default;
+
+  static constexpr std::size_t kChunkSize = 64 * 1024;
+
+  // Old chunks wholly before and after the edits, as counts and byte sizes.
+  // False if the edits don't account for the change in size.
+  bool keptByEdits(
+      const DirtyRanges &edits,
+      std::size_t size,
+      std::size_t &head,
+      std::size_t &head_bytes,
+      std::size_t &tail,
+      std::size_t &tail_bytes
+  ) const;
+  // The same, by comparing the chunks with text
+  void keptByText(
+      const TextSegments &text,
+      std::size_t &head,
+      std::size_t &head_bytes,
+      std::size_t &tail,
+      std::size_t &tail_bytes
+  ) const;
+
+  std::vector<Chunk> chunks_;
+  std::size_t size_ = 0;
+
+  std::string file_path_;
+  std::string filetype_name_;
+  std::string encoding_name_;
+  DirtyRanges dirty_;
+  std::uint64_t text_generation_ = 0;
+
+  mutable std::once_flag flatten_once_;
+  mutable std::string flat_;
+};
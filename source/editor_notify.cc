@@ -0,0 +1,100 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "editor_notify.h"
+
+#include <utility>
+
+#include <geanyplugin.h>
+
+#include "preview_config.h"
+#include "preview_context.h"
+
+namespace {
+// The bits an Event mask is tested against
+int eventFlags(const SCNotification *nt) {
+  switch (nt->nmhdr.code) {
+    case SCN_MODIFIED:
+      return nt->modificationType;
+    case SCN_UPDATEUI:
+      return nt->updated;
+    default:
+      return 0;
+  }
+}
+}  // namespace
+
+void EditorNotify::subscribe(std::vector<Event> events, Handler handler, Enabled enabled) {
+  subscribers_.push_back({ std::move(events), std::move(handler), std::move(enabled) });
+  routes_generation_ = ~std::uint64_t{ 0 };
+
+  auto &ctx = PreviewContext::instance();
+  if (!connected_ && ctx.geany_plugin_) {
+    plugin_signal_connect(
+        ctx.geany_plugin_, nullptr, "editor-notify", false, G_CALLBACK(onEditorNotify), this
+    );
+    connected_ = true;
+  }
+}
+
+gboolean EditorNotify::onEditorNotify(
+    GObject * /*object*/,
+    GeanyEditor *editor,
+    SCNotification *nt,
+    gpointer user_data
+) {
+  if (editor && nt) {
+    static_cast<EditorNotify *>(user_data)->dispatch(editor, nt);
+  }
+  return false;  // let Geany continue processing
+}
+
+void EditorNotify::dispatch(GeanyEditor *editor, const SCNotification *nt) {
+  // Not while handlers run: they may send messages that notify re-entrantly
+  if (depth_ == 0 && routes_generation_ != PreviewConfig::instance().generation()) {
+    rebuild();
+  }
+
+  auto it = routes_.find(static_cast<int>(nt->nmhdr.code));
+  if (it == routes_.end()) {
+    return;
+  }
+
+  const int flags = eventFlags(nt);
+  const auto &entry = it->second;
+  if (entry.mask && !(flags & entry.mask)) {
+    return;
+  }
+
+  ++depth_;
+  for (const auto &route : entry.routes) {
+    if (!route.mask || (flags & route.mask)) {
+      subscribers_[route.subscriber].handler(editor, nt);
+    }
+  }
+  --depth_;
+}
+
+void EditorNotify::rebuild() {
+  routes_.clear();
+  for (std::size_t i = 0; i < subscribers_.size(); ++i) {
+    const auto &subscriber = subscribers_[i];
+    if (subscriber.enabled && !subscriber.enabled()) {
+      continue;
+    }
+
+    for (const auto &event : subscriber.events) {
+      auto [it, inserted] = routes_.try_emplace(event.code);
+      auto &entry = it->second;
+      if (inserted) {
+        entry.mask = event.mask;
+      } else if (entry.mask && event.mask) {
+        entry.mask |= event.mask;
+      } else {
+        entry.mask = 0;
+      }
+      entry.routes.push_back({ event.mask, i });
+    }
+  }
+  routes_generation_ = PreviewConfig::instance().generation();
+}
@@ -0,0 +1,84 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#include <glib-object.h>
+
+struct GeanyEditor;
+struct SCNotification;
+
+// The plugin's one editor-notify handler.  Scintilla sends a notification for
+// nearly everything, so modules subscribe to the codes they handle instead of
+// connecting their own handlers.  Subscribers that are switched off are left
+// out of the routing table, which is rebuilt only when the config changes.
+// Main thread only.
+class EditorNotify final {
+ public:
+  static EditorNotify &instance() {
+    static EditorNotify inst;
+    return inst;
+  }
+
+ private:
+  EditorNotify() = default;
+  ~EditorNotify() = default;
+
+  EditorNotify(const EditorNotify &) = delete;
+  EditorNotify &operator=(const EditorNotify &) = delete;
+  EditorNotify(EditorNotify &&) = delete;
+  EditorNotify &operator=(EditorNotify &&) = delete;
+
+ public:
+  // A notification code, and for SCN_MODIFIED and SCN_UPDATEUI the
+  // modificationType or updated bits of interest (0 = any)
+  struct Event {
+    int code = 0;
+    int mask = 0;
+  };
+
+  using Handler = std::function<void(GeanyEditor *, const SCNotification *)>;
+  // Read when settings change, not per notification
+  using Enabled = std::function<bool()>;
+
+  // Connects to editor-notify on first use.  Without enabled, the handler
+  // always runs.  Not from a handler.
+  void subscribe(std::vector<Event> events, Handler handler, Enabled enabled = {});
+
+ private:
+  struct Subscriber {
+    std::vector<Event> events;
+    Handler handler;
+    Enabled enabled;
+  };
+
+  struct Route {
+    int mask = 0;
+    std::size_t subscriber = 0;
+  };
+
+  struct Routes {
+    int mask = 0;  // union of the routes' masks; 0 if any takes all
+    std::vector<Route> routes;
+  };
+
+  static gboolean
+  onEditorNotify(GObject *, GeanyEditor *editor, SCNotification *nt, gpointer user_data);
+
+  void dispatch(GeanyEditor *editor, const SCNotification *nt);
+  void rebuild();
+
+  bool connected_ = false;
+  int depth_ = 0;  // nested dispatch() calls
+  std::vector<Subscriber> subscribers_;
+
+  // By notification code, enabled subscribers only
+  std::unordered_map<int, Routes> routes_;
+  std::uint64_t routes_generation_ = ~std::uint64_t{ 0 };
+};
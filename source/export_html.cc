@@ -0,0 +1,145 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "export_html.h"
+
+#include <fstream>
+#include <system_error>
+
+#include "asset_inliner.h"
+#include "default_css.h"
+#include "preview_config.h"
+#include "util/file_utils.h"
+#include "util/string_utils.h"
+
+namespace {
+void appendCss(std::string &out, const std::string &name) {
+  auto path = PreviewConfig::instance().configDir() / name;
+  if (FileUtils::fileExists(path)) {
+    try {
+      out += FileUtils::readFileToString(path);
+      out += '\n';
+      return;
+    } catch (...) {
+      // fall back to the built-in stylesheet
+    }
+  }
+  if (auto it = kDefaultCssMap.find(name); it != kDefaultCssMap.end()) {
+    out += it->second;
+    out += '\n';
+  }
+}
+}  // namespace
+
+std::string ExportHtml::stylesheet(std::string_view key, std::string_view theme) {
+  std::string css;
+  appendCss(css, "preview.css");
+  if (!key.empty()) {
+    appendCss(css, std::string{ key } + ".css");
+  }
+
+  if (theme == "light") {
+    css += "html { color-scheme: light; }\n";
+  } else if (theme == "dark") {
+    css += "html { color-scheme: dark; }\n";
+  } else {
+    css += "html { color-scheme: light dark; }\n";
+  }
+  return css;
+}
+
+std::string ExportHtml::pageHead(std::string_view title) {
+  std::string head = "<!doctype html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n";
+  head += "<title>" + StringUtils::escapeHtml(title) + "</title>\n";
+  head += "<style>\n";
+  return head;
+}
+
+std::string
+ExportHtml::page(std::string_view body, std::string_view title, std::string_view css) {
+  std::string html = pageHead(title);
+  html.reserve(html.size() + css.size() + body.size() + 64);
+  html += css;
+  html += kPageMiddle;
+  html += body;
+  html += kPageTail;
+  return html;
+}
+
+bool ExportHtml::writePage(
+    const std::filesystem::path &dest,
+    std::string_view body,
+    std::string_view title,
+    std::string_view css,
+    const std::filesystem::path &asset_dir,
+    std::vector<std::filesystem::path> *asset_files
+) {
+  std::string head = pageHead(title);
+  if (asset_dir.empty()) {
+    return writeParts(dest, { head, css, kPageMiddle, body, kPageTail });
+  }
+
+  auto &inliner = AssetInliner::instance();
+  AssetInliner::Output out;
+  out.text(head);
+  inliner.inlineCss(css, PreviewConfig::instance().configDir(), out);
+  out.text(kPageMiddle);
+  inliner.inlineHtml(body, asset_dir, out);
+  out.text(kPageTail);
+  if (asset_files) {
+    *asset_files = out.files();
+  }
+
+  std::error_code ec;
+  if (!dest.parent_path().empty()) {
+    std::filesystem::create_directories(dest.parent_path(), ec);
+  }
+  std::ofstream file(partialPath(dest), std::ios::binary | std::ios::trunc);
+  bool ok = file && out.write(file);
+  file.close();
+  return finishPartial(dest, ok && file.good());
+}
+
+std::filesystem::path ExportHtml::partialPath(const std::filesystem::path &dest) {
+  auto tmp = dest;
+  tmp += ".part";
+  return tmp;
+}
+
+bool ExportHtml::finishPartial(const std::filesystem::path &dest, bool ok) {
+  std::error_code ec;
+  auto tmp = partialPath(dest);
+  if (ok) {
+    std::filesystem::rename(tmp, dest, ec);
+    ok = !ec;
+  }
+  if (!ok) {
+    std::filesystem::remove(tmp, ec);
+  }
+  return ok;
+}
+
+bool ExportHtml::writeFile(const std::filesystem::path &dest, std::string_view contents) {
+  return writeParts(dest, { contents });
+}
+
+bool ExportHtml::writeParts(
+    const std::filesystem::path &dest,
+    std::initializer_list<std::string_view> parts
+) {
+  std::error_code ec;
+  if (!dest.parent_path().empty()) {
+    std::filesystem::create_directories(dest.parent_path(), ec);
+  }
+
+  // Bounded pieces, so a failed write stops early
+  std::ofstream out(partialPath(dest), std::ios::binary | std::ios::trunc);
+  for (std::string_view part : parts) {
+    for (std::size_t pos = 0; out && pos < part.size(); pos += kWriteChunk) {
+      std::string_view chunk = part.substr(pos, kWriteChunk);
+      out.write(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+    }
+  }
+  out.close();
+  return finishPartial(dest, out.good());
+}
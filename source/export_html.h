@@ -0,0 +1,59 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Standalone pages for exported documents: the rendered body wrapped in a full
+// HTML document with the preview's stylesheets inlined.
+class ExportHtml final {
+ public:
+  // preview.css and <key>.css from the config folder, or the built-in ones,
+  // followed by the color scheme for theme ("light", "dark" or "system").
+  static std::string stylesheet(std::string_view key, std::string_view theme);
+
+  static std::string page(std::string_view body, std::string_view title, std::string_view css);
+
+  // Same page as page(), streamed to dest in pieces without assembling it in
+  // memory first.  Written like writeFile().  With an asset_dir, local
+  // assets are inlined (see AssetInliner); relative ones are resolved against
+  // asset_dir, those of the stylesheet against the config folder.  The files
+  // the page refers to are stored in asset_files, if given.
+  static bool writePage(
+      const std::filesystem::path &dest,
+      std::string_view body,
+      std::string_view title,
+      std::string_view css,
+      const std::filesystem::path &asset_dir = {},
+      std::vector<std::filesystem::path> *asset_files = nullptr
+  );
+
+  // Writes to a temporary file beside dest and renames it over dest, so dest is
+  // never left half-written.  Creates missing parent directories.
+  static bool writeFile(const std::filesystem::path &dest, std::string_view contents);
+
+  // Temporary name beside dest for writers that produce the file themselves.
+  // finishPartial() moves it over dest if ok, otherwise removes it, and
+  // returns whether dest was replaced.
+  static std::filesystem::path partialPath(const std::filesystem::path &dest);
+  static bool finishPartial(const std::filesystem::path &dest, bool ok);
+
+ private:
+  static constexpr std::size_t kWriteChunk = 1024 * 1024;
+
+  static std::string pageHead(std::string_view title);
+  static constexpr std::string_view kPageMiddle = "</style>\n</head>\n<body>\n";
+  static constexpr std::string_view kPageTail = "\n</body>\n</html>\n";
+
+  // Writes parts to partialPath(dest) and moves it over dest.
+  static bool writeParts(
+      const std::filesystem::path &dest,
+      std::initializer_list<std::string_view> parts
+  );
+};
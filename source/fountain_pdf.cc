@@ -0,0 +1,90 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "fountain_pdf.h"
+
+#include <system_error>
+
+#include "export_html.h"
+#include "renderers_pdf.h"  // Fountain::ftn2pdf
+
+bool FountainPdf::write(
+    const Document &document,
+    const std::filesystem::path &dest,
+    const std::atomic<bool> &cancelled
+) {
+  std::error_code ec;
+  if (!dest.parent_path().empty()) {
+    std::filesystem::create_directories(dest.parent_path(), ec);
+  }
+
+  std::size_t hash = document.computeHash();
+  std::filesystem::path partial = ExportHtml::partialPath(dest);
+
+  std::filesystem::path previous;
+  if (findOutput(hash, previous)) {
+    if (std::filesystem::equivalent(previous, dest, ec)) {
+      return true;
+    }
+    if (std::filesystem::copy_file(
+            previous, partial, std::filesystem::copy_options::overwrite_existing, ec
+        )) {
+      bool ok = ExportHtml::finishPartial(dest, !cancelled);
+      if (ok) {
+        addOutput(hash, dest);
+      }
+      return ok;
+    }
+  }
+
+  if (cancelled) {
+    return false;
+  }
+
+  bool ok = Fountain::ftn2pdf(partial.string(), document.text());
+  ok = ExportHtml::finishPartial(dest, ok && !cancelled);
+  if (ok) {
+    addOutput(hash, dest);
+  }
+  return ok;
+}
+
+bool FountainPdf::findOutput(std::size_t hash, std::filesystem::path &file) {
+  std::lock_guard lock(mutex_);
+  auto it = outputs_.find(hash);
+  if (it == outputs_.end()) {
+    return false;
+  }
+
+  // Overwritten or removed since
+  const auto &output = it->second;
+  std::error_code ec;
+  auto mtime = std::filesystem::last_write_time(output.file, ec);
+  if (ec || mtime != output.mtime ||
+      std::filesystem::file_size(output.file, ec) != output.size || ec) {
+    outputs_.erase(it);
+    return false;
+  }
+
+  file = output.file;
+  return true;
+}
+
+void FountainPdf::addOutput(std::size_t hash, const std::filesystem::path &file) {
+  std::error_code ec;
+  Output output{ file, std::filesystem::last_write_time(file, ec), 0 };
+  if (!ec) {
+    output.size = std::filesystem::file_size(file, ec);
+  }
+  if (ec) {
+    return;
+  }
+
+  std::lock_guard lock(mutex_);
+  // A file holds one output; forget the text it was written for before
+  std::erase_if(outputs_, [&](const auto &entry) { return entry.second.file == file; });
+  if (outputs_.size() >= kMaxOutputs) {
+    outputs_.clear();
+  }
+  outputs_.insert_or_assign(hash, std::move(output));
+}
@@ -0,0 +1,60 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+
+#include "document.h"
+
+// Fountain screenplays to PDF with PoDoFo.  Safe to call from worker threads.
+//
+// ftn2pdf lays out and writes the whole script in one call, with no progress
+// and no way to stop it, so the output is written to a partial file and
+// discarded if the export was cancelled meanwhile.  The last PDF written for
+// each script text is remembered, and exporting the same text again copies it
+// instead of laying the script out again.
+class FountainPdf final {
+ public:
+  static FountainPdf &instance() {
+    static FountainPdf inst;
+    return inst;
+  }
+
+ private:
+  FountainPdf() = default;
+  ~FountainPdf() = default;
+
+  FountainPdf(const FountainPdf &) = delete;
+  FountainPdf &operator=(const FountainPdf &) = delete;
+  FountainPdf(FountainPdf &&) = delete;
+  FountainPdf &operator=(FountainPdf &&) = delete;
+
+ public:
+  bool write(
+      const Document &document,
+      const std::filesystem::path &dest,
+      const std::atomic<bool> &cancelled
+  );
+
+ private:
+  static constexpr std::size_t kMaxOutputs = 32;
+
+  struct Output {
+    std::filesystem::path file;
+    std::filesystem::file_time_type mtime;
+    std::uintmax_t size = 0;
+  };
+
+  // Earlier output for the text, if the file is still as written
+  bool findOutput(std::size_t hash, std::filesystem::path &file);
+  void addOutput(std::size_t hash, const std::filesystem::path &file);
+
+  std::mutex mutex_;
+  std::unordered_map<std::size_t, Output> outputs_;  // by text hash
+};
@@ -0,0 +1,480 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "markdown_chunker.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "util/thread_pool.h"
+
+namespace {
+
+bool isBlank(std::string_view line) {
+  return line.find_first_not_of(" \t") == std::string_view::npos;
+}
+
+// Leading indentation in columns; a tab counts as a full indent.
+std::size_t indentOf(std::string_view line) {
+  std::size_t n = 0;
+  for (char c : line) {
+    if (c == ' ') {
+      ++n;
+    } else if (c == '\t') {
+      return 4;
+    } else {
+      break;
+    }
+  }
+  return n;
+}
+
+// Length of a list marker at the start of the line, or 0.
+std::size_t listMarkerLength(std::string_view line) {
+  if (line.empty()) {
+    return 0;
+  }
+  std::size_t i = 0;
+  if (line[0] == '-' || line[0] == '+' || line[0] == '*') {
+    i = 1;
+  } else {
+    while (i < line.size() && i < 9 && std::isdigit(static_cast<unsigned char>(line[i]))) {
+      ++i;
+    }
+    if (i == 0 || i >= line.size() || (line[i] != '.' && line[i] != ')')) {
+      return 0;
+    }
+    ++i;
+  }
+  if (i < line.size() && line[i] != ' ' && line[i] != '\t') {
+    return 0;
+  }
+  return i;
+}
+
+// Removes indentation, block quote markers and list markers.
+std::string_view stripContainers(std::string_view line) {
+  for (;;) {
+    auto b = line.find_first_not_of(" \t");
+    if (b == std::string_view::npos) {
+      return {};
+    }
+    line.remove_prefix(b);
+    if (line.front() == '>') {
+      line.remove_prefix(1);
+    } else if (auto n = listMarkerLength(line)) {
+      line.remove_prefix(n);
+    } else {
+      return line;
+    }
+  }
+}
+
+bool startsWithNoCase(std::string_view s, std::string_view prefix) {
+  if (s.size() < prefix.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < prefix.size(); ++i) {
+    if (std::tolower(static_cast<unsigned char>(s[i])) != prefix[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool containsNoCase(std::string_view s, std::string_view needle) {
+  for (std::size_t i = 0; i + needle.size() <= s.size(); ++i) {
+    if (startsWithNoCase(s.substr(i), needle)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+struct Fence {
+  char ch = 0;
+  std::size_t len = 0;
+};
+
+Fence fenceAt(std::string_view line) {
+  if (indentOf(line) > 3) {
+    return {};
+  }
+  line.remove_prefix(std::min(line.find_first_not_of(' '), line.size()));
+  if (line.empty()) {
+    return {};
+  }
+  char ch = line.front();
+  if (ch != '`' && ch != '~') {
+    return {};
+  }
+  std::size_t n = line.find_first_not_of(ch);
+  n = (n == std::string_view::npos) ? line.size() : n;
+  if (n < 3) {
+    return {};
+  }
+  if (ch == '`' && line.find('`', n) != std::string_view::npos) {
+    return {};  // inline code span, not a fence
+  }
+  return { ch, n };
+}
+
+bool closesFence(std::string_view line, const Fence &fence) {
+  if (indentOf(line) > 3 || isBlank(line)) {
+    return false;
+  }
+  line.remove_prefix(line.find_first_not_of(' '));
+  std::size_t n = line.find_first_not_of(fence.ch);
+  n = (n == std::string_view::npos) ? line.size() : n;
+  return n >= fence.len && isBlank(line.substr(n));
+}
+
+// Returns the end marker of an HTML block that may span blank lines, or empty.
+std::string_view htmlBlockEnd(std::string_view content) {
+  static constexpr std::string_view kRawTags[] = { "<script", "<pre", "<style", "<textarea" };
+  for (auto tag : kRawTags) {
+    if (startsWithNoCase(content, tag)) {
+      return "</";  // any of </script>, </pre>, </style>, </textarea>
+    }
+  }
+  if (content.starts_with("<!--")) {
+    return "-->";
+  }
+  if (content.starts_with("<?")) {
+    return "?>";
+  }
+  if (content.starts_with("<![CDATA[")) {
+    return "]]>";
+  }
+  if (content.size() > 2 && content.starts_with("<!") &&
+      std::isalpha(static_cast<unsigned char>(content[2]))) {
+    return ">";
+  }
+  return {};
+}
+
+bool endsHtmlBlock(std::string_view line, std::string_view end) {
+  if (end == "</") {
+    return containsNoCase(line, "</script>") || containsNoCase(line, "</pre>") ||
+           containsNoCase(line, "</style>") || containsNoCase(line, "</textarea>");
+  }
+  return line.find(end) != std::string_view::npos;
+}
+
+// Validates a link reference definition that fits entirely on one line.
+// Sets has_title so the caller can reject titles continued on the next line.
+bool isSingleLineDefinition(std::string_view line, bool &has_title) {
+  has_title = false;
+  line.remove_prefix(std::min(line.find_first_not_of(' '), line.size()));
+
+  // [label]:
+  std::size_t i = 1;
+  bool label_text = false;
+  for (; i < line.size() && line[i] != ']'; ++i) {
+    if (line[i] == '[') {
+      return false;
+    }
+    if (line[i] == '\\' && i + 1 < line.size()) {
+      ++i;
+    }
+    label_text = label_text || (line[i] != ' ' && line[i] != '\t');
+  }
+  if (!label_text || i > 1000 || i + 1 >= line.size() || line[i + 1] != ':') {
+    return false;
+  }
+  std::string_view rest = line.substr(i + 2);
+
+  // destination
+  auto b = rest.find_first_not_of(" \t");
+  if (b == std::string_view::npos) {
+    return false;  // destination on the next line
+  }
+  rest.remove_prefix(b);
+  std::size_t d = 0;
+  if (rest.front() == '<') {
+    for (d = 1; d < rest.size() && rest[d] != '>'; ++d) {
+      if (rest[d] == '<') {
+        return false;
+      }
+      if (rest[d] == '\\') {
+        ++d;
+      }
+    }
+    if (d >= rest.size()) {
+      return false;
+    }
+    ++d;
+  } else {
+    int depth = 0;
+    for (; d < rest.size(); ++d) {
+      auto c = static_cast<unsigned char>(rest[d]);
+      if (c <= ' ') {
+        break;
+      }
+      if (c == '\\') {
+        ++d;
+      } else if (c == '(') {
+        ++depth;
+      } else if (c == ')' && --depth < 0) {
+        return false;
+      }
+    }
+    if (depth != 0) {
+      return false;
+    }
+  }
+  rest.remove_prefix(std::min(d, rest.size()));
+
+  // optional title
+  b = rest.find_first_not_of(" \t");
+  if (b == std::string_view::npos) {
+    return true;
+  }
+  if (b == 0) {
+    return false;  // title must be separated from destination
+  }
+  rest.remove_prefix(b);
+  char open = rest.front();
+  char close = (open == '(') ? ')' : open;
+  if (open != '"' && open != '\'' && open != '(') {
+    return false;
+  }
+  std::size_t t = 1;
+  for (; t < rest.size() && rest[t] != close; ++t) {
+    if (open == '(' && rest[t] == '(') {
+      return false;
+    }
+    if (rest[t] == '\\') {
+      ++t;
+    }
+  }
+  if (t >= rest.size()) {
+    return false;
+  }
+  has_title = true;
+  return isBlank(rest.substr(t + 1));
+}
+
+}  // namespace
+
+bool MarkdownChunker::split(
+    std::string_view source,
+    std::size_t target_size,
+    std::vector<Chunk> &chunks
+) {
+  chunks.clear();
+
+  // footnotes are numbered and collected document-wide
+  if (source.find("[^") != std::string_view::npos) {
+    return false;
+  }
+
+  Fence fence;
+  std::string_view html_end;
+  bool prev_blank = true;
+  bool prev_definition = false;
+  bool check_title_continuation = false;
+
+  std::size_t chunk_start = 0;
+  long chunk_line = 1;
+  std::vector<std::string_view> definitions;
+
+  long line_no = 0;
+  for (std::size_t pos = 0; pos < source.size();) {
+    ++line_no;
+    std::size_t nl = source.find('\n', pos);
+    std::size_t next = (nl == std::string_view::npos) ? source.size() : nl + 1;
+    std::string_view line = source.substr(pos, next - pos);
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r')) {
+      line.remove_suffix(1);
+    }
+    std::size_t line_start = pos;
+    pos = next;
+
+    if (fence.ch) {
+      if (closesFence(line, fence)) {
+        fence = {};
+      }
+      prev_blank = prev_definition = false;
+      continue;
+    }
+    if (!html_end.empty()) {
+      if (endsHtmlBlock(line, html_end)) {
+        html_end = {};
+      }
+      prev_blank = prev_definition = false;
+      continue;
+    }
+
+    bool blank = isBlank(line);
+    if (check_title_continuation && !blank) {
+      auto c = line.find_first_not_of(" \t");
+      if (line[c] == '"' || line[c] == '\'' || line[c] == '(') {
+        return false;  // title may continue the previous definition
+      }
+    }
+    check_title_continuation = false;
+
+    if (blank) {
+      prev_blank = true;
+      prev_definition = false;
+      continue;
+    }
+
+    std::size_t indent = indentOf(line);
+    if (prev_blank && indent == 0 && line_start - chunk_start >= target_size &&
+        listMarkerLength(line) == 0) {
+      chunks.push_back({ source.substr(chunk_start, line_start - chunk_start),
+                         chunk_line,
+                         std::move(definitions) });
+      definitions.clear();
+      chunk_start = line_start;
+      chunk_line = line_no;
+    }
+
+    std::string_view content = stripContainers(line);
+    bool definition = false;
+    if (content.starts_with('[') && content.find("]:") != std::string_view::npos) {
+      bool has_title = false;
+      bool top_level = indent <= 3 && content.data() == line.data() + indent;
+      if (!top_level || !(prev_blank || prev_definition) ||
+          !isSingleLineDefinition(line, has_title)) {
+        return false;
+      }
+      definitions.push_back(line);
+      definition = true;
+      check_title_continuation = !has_title;
+    } else if (auto f = fenceAt(line); f.ch) {
+      fence = f;
+    } else if (auto end = htmlBlockEnd(content); !end.empty()) {
+      if (!endsHtmlBlock(content.substr(2), end)) {
+        html_end = end;
+      }
+    }
+
+    prev_blank = false;
+    prev_definition = definition;
+  }
+
+  chunks.push_back(
+      { source.substr(chunk_start), chunk_line, std::move(definitions) }
+  );
+  return chunks.size() > 1;
+}
+
+bool MarkdownChunker::render(
+    std::string_view source,
+    std::size_t min_chunk_size,
+    const RenderFn &render_fn,
+    bool shift_sourcepos,
+    std::string &out
+) {
+  auto &pool = ThreadPool::instance();
+  std::size_t threads = pool.concurrency();
+  if (threads < 2) {
+    return false;
+  }
+
+  std::size_t target = std::max(min_chunk_size, source.size() / (threads * 2));
+  std::vector<Chunk> chunks;
+  if (!split(source, target, chunks)) {
+    return false;
+  }
+
+  // Definitions from earlier chunks go before the chunk so the first one still wins;
+  // later ones go after it so line numbers only need a constant shift.
+  std::vector<std::string> results(chunks.size());
+  bool ok = pool.parallelFor(chunks.size(), [&](std::size_t k) {
+    std::string input;
+    long prelude_lines = 0;
+    for (std::size_t j = 0; j < k; ++j) {
+      for (auto def : chunks[j].definitions) {
+        input.append(def).push_back('\n');
+        ++prelude_lines;
+      }
+    }
+    if (prelude_lines > 0) {
+      input.push_back('\n');
+      ++prelude_lines;
+    }
+    input.append(chunks[k].text);
+    bool separated = false;
+    for (std::size_t j = k + 1; j < chunks.size(); ++j) {
+      for (auto def : chunks[j].definitions) {
+        if (!separated) {
+          input.append("\n\n");
+          separated = true;
+        }
+        input.append(def).push_back('\n');
+      }
+    }
+
+    std::string html = render_fn(input);
+    if (shift_sourcepos) {
+      long delta = chunks[k].first_line - 1 - prelude_lines;
+      results[k].reserve(html.size());
+      appendShiftedSourcepos(results[k], html, delta);
+    } else {
+      results[k] = std::move(html);
+    }
+  });
+  if (!ok) {
+    return false;
+  }
+
+  std::size_t total = 0;
+  for (const auto &r : results) {
+    total += r.size();
+  }
+  out.clear();
+  out.reserve(total);
+  for (const auto &r : results) {
+    out.append(r);
+  }
+  return true;
+}
+
+void MarkdownChunker::appendShiftedSourcepos(std::string &out, std::string_view html, long delta) {
+  static constexpr std::string_view kAttr = "data-sourcepos=\"";
+
+  auto parse = [](std::string_view s, std::size_t &i, long &value) {
+    auto [ptr, ec] = std::from_chars(s.data() + i, s.data() + s.size(), value);
+    if (ec != std::errc{}) {
+      return false;
+    }
+    i = ptr - s.data();
+    return true;
+  };
+
+  std::size_t pos = 0;
+  while (pos < html.size()) {
+    std::size_t at = html.find(kAttr, pos);
+    if (at == std::string_view::npos) {
+      break;
+    }
+    std::size_t i = at + kAttr.size();
+    out.append(html.substr(pos, i - pos));
+    pos = i;
+
+    // l:c-l:c
+    long l1, c1, l2, c2;
+    if (!parse(html, i, l1) || i >= html.size() || html[i++] != ':' || !parse(html, i, c1) ||
+        i >= html.size() || html[i++] != '-' || !parse(html, i, l2) || i >= html.size() ||
+        html[i++] != ':' || !parse(html, i, c2)) {
+      continue;  // not ours; copied verbatim
+    }
+    out.append(std::to_string(l1 + delta))
+        .append(":")
+        .append(std::to_string(c1))
+        .append("-")
+        .append(std::to_string(l2 + delta))
+        .append(":")
+        .append(std::to_string(c2));
+    pos = i;
+  }
+  out.append(html.substr(pos));
+}
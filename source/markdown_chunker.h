@@ -0,0 +1,41 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Splits large Markdown documents at top-level block boundaries and renders the
+// pieces in parallel.  Splitting is conservative: any construct that could make
+// the concatenated output differ from a single-pass render disables it.
+class MarkdownChunker {
+ public:
+  struct Chunk {
+    std::string_view text;
+    long first_line = 1;  // 1-based line of text[0] in the source
+    std::vector<std::string_view> definitions;  // link reference definitions
+  };
+
+  // Renders one self-contained Markdown string; must be safe to call concurrently.
+  using RenderFn = std::function<std::string(std::string_view)>;
+
+  // Returns false if the source is not safely splittable into more than one chunk.
+  static bool split(std::string_view source, std::size_t target_size, std::vector<Chunk> &chunks);
+
+  // Renders the source chunk by chunk on the thread pool. If shift_sourcepos is
+  // set, data-sourcepos attributes are rebased to source line numbers.
+  static bool render(
+      std::string_view source,
+      std::size_t min_chunk_size,
+      const RenderFn &render_fn,
+      bool shift_sourcepos,
+      std::string &out
+  );
+
+ private:
+  static void appendShiftedSourcepos(std::string &out, std::string_view html, long delta);
+};
@@ -0,0 +1,203 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "offscreen_pdf.h"
+
+#include <system_error>
+#include <unordered_map>
+
+#include <gtk/gtk.h>
+
+#include "export_html.h"
+
+namespace {
+constexpr guint kProgressInterval = 250;  // ms
+
+struct PrintJob {
+  guint id = 0;
+  GtkWidget *window = nullptr;
+  WebKitWebView *view = nullptr;
+  std::filesystem::path dest;
+  std::function<void(bool)> done;
+  std::function<void(OffscreenPdf::Stage, std::uintmax_t)> progress;
+  gulong load_handler = 0;
+  guint progress_source = 0;
+  bool failed = false;
+  bool printing = false;
+  bool cancelled = false;
+};
+
+std::unordered_map<guint, PrintJob *> &jobs() {
+  static std::unordered_map<guint, PrintJob *> map;
+  return map;
+}
+
+void finish(PrintJob *job, bool ok) {
+  jobs().erase(job->id);
+  if (job->progress_source) {
+    g_source_remove(job->progress_source);
+    job->progress_source = 0;
+  }
+
+  ok = ExportHtml::finishPartial(job->dest, ok && !job->cancelled);
+  auto done = std::move(job->done);
+
+  // Called from the view's own signals; destroy it once they have returned
+  g_idle_add(
+      [](gpointer data) -> gboolean {
+        auto *job = static_cast<PrintJob *>(data);
+        gtk_widget_destroy(job->window);
+        delete job;
+        return G_SOURCE_REMOVE;
+      },
+      job
+  );
+
+  if (done) {
+    done(ok);
+  }
+}
+
+void startPrint(PrintJob *job) {
+  std::filesystem::path partial = ExportHtml::partialPath(job->dest);
+  gchar *uri = g_filename_to_uri(partial.c_str(), nullptr, nullptr);
+  if (!uri) {
+    finish(job, false);
+    return;
+  }
+
+  GtkPrintSettings *settings = gtk_print_settings_new();
+  gtk_print_settings_set(settings, GTK_PRINT_SETTINGS_PRINTER, "Print to File");
+  gtk_print_settings_set(settings, GTK_PRINT_SETTINGS_OUTPUT_FILE_FORMAT, "pdf");
+  gtk_print_settings_set(settings, GTK_PRINT_SETTINGS_OUTPUT_URI, uri);
+  g_free(uri);
+
+  WebKitPrintOperation *op = webkit_print_operation_new(job->view);
+  webkit_print_operation_set_print_settings(op, settings);
+
+  GtkPageSetup *page_setup = gtk_page_setup_new();
+  webkit_print_operation_set_page_setup(op, page_setup);
+
+  g_signal_connect(
+      op,
+      "failed",
+      G_CALLBACK(+[](WebKitPrintOperation *, GError *, gpointer user_data) {
+        static_cast<PrintJob *>(user_data)->failed = true;
+      }),
+      job
+  );
+  g_signal_connect(
+      op,
+      "finished",
+      G_CALLBACK(+[](WebKitPrintOperation *, gpointer user_data) {
+        auto *job = static_cast<PrintJob *>(user_data);
+        finish(job, !job->failed);
+      }),
+      job
+  );
+
+  job->printing = true;
+  if (job->progress) {
+    job->progress(OffscreenPdf::Stage::Printing, 0);
+    job->progress_source = g_timeout_add(
+        kProgressInterval,
+        [](gpointer data) -> gboolean {
+          auto *job = static_cast<PrintJob *>(data);
+          std::error_code ec;
+          auto size = std::filesystem::file_size(ExportHtml::partialPath(job->dest), ec);
+          job->progress(OffscreenPdf::Stage::Printing, ec ? 0 : size);
+          return G_SOURCE_CONTINUE;
+        },
+        job
+    );
+  }
+
+  webkit_print_operation_print(op);
+
+  g_object_unref(settings);
+  g_object_unref(page_setup);
+  g_object_unref(op);
+}
+}  // namespace
+
+guint OffscreenPdf::print(
+    const std::string &html,
+    const std::string &base_uri,
+    const std::filesystem::path &dest,
+    std::function<void(bool)> done,
+    Options options
+) {
+  static guint next_id = 0;
+
+  std::error_code ec;
+  if (!dest.parent_path().empty()) {
+    std::filesystem::create_directories(dest.parent_path(), ec);
+  }
+
+  auto *job = new PrintJob;
+  job->id = ++next_id;
+  job->dest = dest;
+  job->done = std::move(done);
+  job->progress = std::move(options.progress);
+  job->window = gtk_offscreen_window_new();
+  job->view = WEBKIT_WEB_VIEW(
+      options.context ? webkit_web_view_new_with_context(options.context)
+                      : webkit_web_view_new()
+  );
+  if (options.settings) {
+    webkit_web_view_set_settings(job->view, options.settings);
+  }
+  gtk_container_add(GTK_CONTAINER(job->window), GTK_WIDGET(job->view));
+  gtk_widget_show_all(job->window);
+  jobs().emplace(job->id, job);
+
+  g_signal_connect(
+      job->view,
+      "load-failed",
+      G_CALLBACK(+[](WebKitWebView *, WebKitLoadEvent, gchar *, GError *, gpointer user_data)
+                     -> gboolean {
+        static_cast<PrintJob *>(user_data)->failed = true;
+        return false;
+      }),
+      job
+  );
+  job->load_handler = g_signal_connect(
+      job->view,
+      "load-changed",
+      G_CALLBACK(+[](WebKitWebView *view, WebKitLoadEvent event, gpointer user_data) {
+        if (event != WEBKIT_LOAD_FINISHED) {
+          return;
+        }
+        auto *job = static_cast<PrintJob *>(user_data);
+        g_signal_handler_disconnect(view, job->load_handler);
+        if (job->failed || job->cancelled) {
+          finish(job, false);
+        } else {
+          startPrint(job);
+        }
+      }),
+      job
+  );
+
+  if (job->progress) {
+    job->progress(Stage::Loading, 0);
+  }
+  webkit_web_view_load_html(
+      job->view, html.c_str(), base_uri.empty() ? nullptr : base_uri.c_str()
+  );
+  return job->id;
+}
+
+void OffscreenPdf::cancel(guint id) {
+  auto it = jobs().find(id);
+  if (it == jobs().end()) {
+    return;
+  }
+
+  PrintJob *job = it->second;
+  job->cancelled = true;
+  // Ends with load-changed FINISHED; a print runs to its "finished" signal
+  if (!job->printing) {
+    webkit_web_view_stop_loading(job->view);
+  }
+}
@@ -0,0 +1,42 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+
+#include <glib.h>
+#include <webkit2/webkit2.h>
+
+// Prints an HTML page to a PDF file with a WebKit view that is never shown,
+// leaving the preview pane alone.  Main thread only.  Each call gets its own
+// view, destroyed once printing ends; done(ok) runs after dest is in place.
+class OffscreenPdf final {
+ public:
+  enum class Stage { Loading, Printing };
+
+  struct Options {
+    // Shared with the preview so the page renders the same; null for defaults
+    WebKitWebContext *context = nullptr;
+    WebKitSettings *settings = nullptr;
+    // WebKit doesn't report pages, so progress is the stage and the size of
+    // the PDF written so far
+    std::function<void(Stage stage, std::uintmax_t bytes)> progress;
+  };
+
+  // Returns an id for cancel().
+  static guint print(
+      const std::string &html,
+      const std::string &base_uri,
+      const std::filesystem::path &dest,
+      std::function<void(bool)> done,
+      Options options = {}
+  );
+
+  // Stops loading, or discards the output of a print already handed to WebKit,
+  // which cannot be interrupted.  done(false) follows once the view is idle.
+  static void cancel(guint id);
+};
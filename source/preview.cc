@@ -6,12 +6,19 @@
 
 #include <geanyplugin.h>
 
+#include "auto_export.h"
+#include "batch_export.h"
 #include "config.h"
+#include "converter_registrar.h"
+#include "document_geany.h"
+#include "editor_notify.h"
 #include "preview_config.h"
 #include "preview_context.h"
 #include "preview_menu.h"
 #include "preview_pane.h"
 #include "preview_shortcuts.h"
+#include "subprocess.h"
+#include "tool_probe.h"
 #include "tweakui_auto_set_pwd.h"
 #include "tweakui_auto_set_read_only.h"
 #include "tweakui_color_tip.h"
@@ -22,32 +29,74 @@
 #include "tweakui_redetect_filetype.h"
 #include "tweakui_sidebar_auto_resize.h"
 #include "tweakui_unchange_document.h"
+#include "util/main_thread.h"
+#include "util/thread_pool.h"
 
 namespace {
-gboolean onEditorNotify(
+// Text insertions and deletions only: restyling, markers, indicators and undo
+// bookkeeping leave the text and its generation as they were
+void onTextModified(GeanyEditor *editor, const SCNotification *notification) {
+  const int type = notification->modificationType;
+  auto length = static_cast<std::size_t>(notification->length);
+  DocumentGeany::recordChange(
+      editor->document,
+      static_cast<std::size_t>(notification->position),
+      (type & SC_MOD_DELETETEXT) ? length : 0,
+      (type & SC_MOD_INSERTTEXT) ? length : 0,
+      notification->linesAdded
+  );
+
+  auto &pane = PreviewPane::instance();
+  pane.scheduleUpdate();
+}
+
+void onDocumentActivate(
     GObject * /*object*/,
-    GeanyEditor *editor,
-    SCNotification *notification,
+    GeanyDocument *geany_document,
     gpointer /*user_data*/
 ) {
-  if (!notification || notification->nmhdr.code != SCN_MODIFIED) {
-    return false;
-  }
-
   auto &pane = PreviewPane::instance();
   pane.scheduleUpdate();
-  return false;
 }
 
-void onDocumentActivate(
+// Saved (possibly renamed), retyped or reloaded: path, filetype or encoding
+// may have changed
+void onDocumentChanged(
     GObject * /*object*/,
     GeanyDocument *geany_document,
     gpointer /*user_data*/
 ) {
+  DocumentGeany::invalidate(geany_document);
   auto &pane = PreviewPane::instance();
   pane.scheduleUpdate();
 }
 
+void onDocumentSave(
+    GObject * /*object*/,
+    GeanyDocument *geany_document,
+    gpointer /*user_data*/
+) {
+  onDocumentChanged(nullptr, geany_document, nullptr);
+  AutoExport::instance().documentSaved(DocumentGeany(geany_document));
+}
+
+void onDocumentFiletypeSet(
+    GObject * /*object*/,
+    GeanyDocument *geany_document,
+    GeanyFiletype * /*filetype_old*/,
+    gpointer /*user_data*/
+) {
+  onDocumentChanged(nullptr, geany_document, nullptr);
+}
+
+void onDocumentClose(
+    GObject * /*object*/,
+    GeanyDocument *geany_document,
+    gpointer /*user_data*/
+) {
+  DocumentGeany::forget(geany_document);
+}
+
 GtkWidget *previewConfigure(
     GeanyPlugin * /*plugin*/,
     GtkDialog *dialog,
@@ -76,8 +125,8 @@ gboolean previewInit(
   PreviewPane::instance();
 
   // signals
-  plugin_signal_connect(
-      plugin, nullptr, "editor-notify", false, G_CALLBACK(onEditorNotify), nullptr
+  EditorNotify::instance().subscribe(
+      { { SCN_MODIFIED, SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT } }, onTextModified
   );
 
   plugin_signal_connect(
@@ -85,7 +134,24 @@ gboolean previewInit(
   );
 
   plugin_signal_connect(
-      plugin, nullptr, "document-save", false, G_CALLBACK(onDocumentActivate), nullptr
+      plugin, nullptr, "document-save", false, G_CALLBACK(onDocumentSave), nullptr
+  );
+
+  plugin_signal_connect(
+      plugin, nullptr, "document-reload", false, G_CALLBACK(onDocumentChanged), nullptr
+  );
+
+  plugin_signal_connect(
+      plugin,
+      nullptr,
+      "document-filetype-set",
+      false,
+      G_CALLBACK(onDocumentFiletypeSet),
+      nullptr
+  );
+
+  plugin_signal_connect(
+      plugin, nullptr, "document-close", false, G_CALLBACK(onDocumentClose), nullptr
   );
 
   // tweaks
@@ -102,6 +168,18 @@ gboolean previewInit(
   // config - delayed load
   cfg.load();
 
+  // resolve converter binaries in the background once the UI is idle
+  g_idle_add(
+      [](gpointer) -> gboolean {
+        auto &cfg = PreviewConfig::instance();
+        ToolProbe::instance().startAsync(
+            cfg.configDir() / "tools.toml", ConverterRegistrar::binaries()
+        );
+        return G_SOURCE_REMOVE;
+      },
+      nullptr
+  );
+
   return true;
 }
 
@@ -109,6 +187,15 @@ void previewCleanup(
     GeanyPlugin *plugin,
     gpointer /*user_data*/
 ) {
+  BatchExport::instance().cancel();
+  PreviewPane::instance().cancelPdfExport();
+  Subprocess::shutdown();  // external converters return at once
+
+  // Running tasks finish; the results they hand back are dropped unseen
+  ThreadPool::instance().shutdown();
+  MainThread::instance().shutdown();
+  PreviewPane::instance().releaseConverters();
+
   PreviewConfig::instance().save();
 }
 }  // namespace
@@ -225,11 +225,32 @@ static void onSearchEntryChanged(GtkEditable *editable, gpointer user_data) {
 }  // namespace
 
 PreviewConfig::PreviewConfig() {
-  // Populate settings_ and help_texts_ from the master table
+  // Populate values_ from the master table
+  values_.reserve(setting_defs_.size());
   for (const auto &def : setting_defs_) {
-    settings_[def.key] = def.default_value;
-    help_texts_[def.key] = def.help;
+    index_.emplace(def.key, values_.size());
+    values_.push_back(def.default_value);
   }
+  notified_ = values_;
+}
+
+std::size_t
+PreviewConfig::addSetting(const char *key, setting_value_type default_value, const char *help) {
+  // Constructed first, so it doesn't copy the new entry from the table too
+  auto &cfg = instance();
+  if (auto it = cfg.index_.find(key); it != cfg.index_.end()) {
+    return it->second;
+  }
+
+  // Extend the master table so the GUI sees it
+  std::unique_lock lock(cfg.values_mutex_);
+  std::size_t index = cfg.values_.size();
+  setting_defs_.push_back({ key, default_value, help });
+  cfg.notified_.push_back(default_value);
+  cfg.values_.push_back(std::move(default_value));
+  cfg.index_.emplace(key, index);
+  ++cfg.generation_;
+  return index;
 }
 
 bool PreviewConfig::load() {
@@ -240,8 +261,10 @@ bool PreviewConfig::load() {
 
   try {
     auto tbl = toml::parse_file(full_path.string());
+    std::unique_lock lock(values_mutex_);
+    ++generation_;
     if (auto preview_tbl = tbl["Preview"].as_table()) {
-      for (auto &[key, value] : settings_) {
+      for (const auto &[key, index] : index_) {
         auto node = (*preview_tbl)[key];
         std::visit(
             [&](auto &current) {
@@ -276,10 +299,11 @@ bool PreviewConfig::load() {
                 }
               }
             },
-            value
+            values_[index]
         );
       }
     }
+    notified_ = values_;  // loaded values are the baseline, not changes
     return true;
   } catch (const toml::parse_error &err) {
     auto desc = err.description();
@@ -290,7 +314,7 @@ bool PreviewConfig::load() {
 
 bool PreviewConfig::save() const {
   toml::table preview_tbl;
-  for (const auto &[key, value] : settings_) {
+  for (const auto &[key, index] : index_) {
     std::visit(
         [&](auto &&current) {
           using T = std::decay_t<decltype(current)>;
@@ -306,7 +330,7 @@ bool PreviewConfig::save() const {
             preview_tbl.insert_or_assign(key, std::move(arr));
           }
         },
-        value
+        values_[index]
     );
   }
   toml::table root;
@@ -323,6 +347,43 @@ bool PreviewConfig::save() const {
   }
 }
 
+void PreviewConfig::emitChanged() {
+  Changes changed;
+  for (std::size_t i = 0; i < values_.size(); ++i) {
+    if (values_[i] != notified_[i]) {
+      changed.push_back(setting_defs_[i].key);
+    }
+  }
+  notified_ = values_;
+  if (changed.empty()) {
+    return;
+  }
+
+  auto matches = [](const std::string &pattern, std::string_view key) {
+    if (!pattern.empty() && pattern.back() == '*') {
+      return key.starts_with(std::string_view{ pattern }.substr(0, pattern.size() - 1));
+    }
+    return key == pattern;
+  };
+
+  // By index: a callback may subscribe
+  for (std::size_t i = 0; i < subscriptions_.size(); ++i) {
+    Changes relevant;
+    for (std::string_view key : changed) {
+      const auto &patterns = subscriptions_[i].patterns;
+      if (std::any_of(patterns.begin(), patterns.end(), [&](const std::string &p) {
+            return matches(p, key);
+          })) {
+        relevant.push_back(key);
+      }
+    }
+    if (!relevant.empty()) {
+      auto callback = subscriptions_[i].callback;
+      callback(relevant);
+    }
+  }
+}
+
 void PreviewConfig::onDialogResponse(GtkDialog *dialog, gint response_id) {
   switch (response_id) {
     case GTK_RESPONSE_APPLY:
@@ -339,7 +400,7 @@ void PreviewConfig::onDialogResponse(GtkDialog *dialog, gint response_id) {
   }
 }
 
-// Builds and returns a populated GtkListStore from settings_
+// Builds and returns a populated GtkListStore from values_
 GtkListStore *PreviewConfig::createConfigModel() {
   GtkListStore *store = gtk_list_store_new(
       NUM_COLS,
@@ -352,13 +413,9 @@ GtkListStore *PreviewConfig::createConfigModel() {
       G_TYPE_BOOLEAN   // show text?
   );
 
-  for (const auto &def : setting_defs_) {
-    auto it = settings_.find(def.key);
-    if (it == settings_.end()) {
-      continue;
-    }
-
-    const auto &val = it->second;
+  for (std::size_t i = 0; i < values_.size(); ++i) {
+    const auto &def = setting_defs_[i];
+    const auto &val = values_[i];
     std::string type, value_str;
     gboolean value_bool = false;
 
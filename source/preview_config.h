@@ -3,16 +3,51 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <functional>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
 #include <string_view>
+#include <type_traits>
 #include <unordered_map>
 #include <variant>
 #include <vector>
 
 #include <gtk/gtk.h>
 
+// Types a setting can hold
+template <typename T>
+concept SettingValue = std::is_same_v<T, int> || std::is_same_v<T, double> ||
+                       std::is_same_v<T, bool> || std::is_same_v<T, std::string> ||
+                       std::is_same_v<T, std::vector<int>> ||
+                       std::is_same_v<T, std::vector<std::string>>;
+
+// Typed handle to a setting: its index in the value array, resolved once by
+// name.  Reading through a handle is an indexed load instead of building a
+// string and looking it up, for paths that run on every edit or event.
+template <SettingValue T>
+class Setting {
+ public:
+  // Unknown keys and keys of another type read as T{}.
+  explicit Setting(std::string_view key);
+  Setting() = default;
+
+  std::size_t index() const noexcept {
+    return index_;
+  }
+
+ private:
+  friend class PreviewConfig;
+  struct Index {};
+  Setting(Index, std::size_t index) : index_(index) {}
+
+  std::size_t index_ = static_cast<std::size_t>(-1);
+};
+
 class PreviewConfig {
  public:
   static PreviewConfig &init(const std::filesystem::path &path, std::string_view file) {
@@ -55,10 +90,36 @@ class PreviewConfig {
 
   // clang-format off
   inline static std::vector<SettingDef> setting_defs_ = {
+    { "auto_export_dir",
+      setting_value_type{ std::string{ "" } },
+      "Export documents to HTML in this folder each time they are saved, "
+      "relative to the document's folder. Empty disables." },
+
+    { "batch_export_external_jobs",
+      setting_value_type{ 2 },
+      "Batch export: documents converted at once by external programs (pandoc, asciidoctor)." },
+
+    { "batch_export_jobs",
+      setting_value_type{ 0 },
+      "Batch export: documents converted at once by built-in converters. 0 = automatic." },
+
+    { "code_highlight",
+      setting_value_type{ true },
+      "Highlight fenced code blocks that specify a known language." },
+
     { "disable_preview_ctrl_wheel_zoom",
       setting_value_type{ false },
       "Disable Ctrl+MouseWheel zoom in the preview pane." },
 
+    { "export_inline_outside_folder",
+      setting_value_type{ false },
+      "Self-contained export: also embed files outside the document's folder "
+      "(the config folder for its stylesheets)." },
+
+    { "export_self_contained",
+      setting_value_type{ false },
+      "Embed local images, stylesheets and fonts in exported HTML, so it works when moved." },
+
     { "file_manager_command",
       setting_value_type{ std::string{ "xdg-open %d" } },
       "Command to launch a file manager. %d = current document directory." },
@@ -71,12 +132,29 @@ class PreviewConfig {
       setting_value_type{ false },
       "Change focus only if editor or preview/sidebar has focus; otherwise do nothing." },
 
+    { "markdown_max_size",
+      setting_value_type{ 16777216 },
+      "Markdown documents larger than this (bytes) are shown as plain text. 0 disables." },
+
+    { "markdown_parallel_min_size",
+      setting_value_type{ 1048576 },
+      "Minimum Markdown document size (bytes) to render in parallel chunks. 0 disables." },
+
+    { "markdown_sourcepos",
+      setting_value_type{ std::string{ "table" } },
+      "Markdown source positions: table = side table attached on demand, "
+      "inline = data-sourcepos attributes, none = omit." },
+
     { "preview_base_path",
       setting_value_type{ std::string{ "sandbox" } },
       "Base path for preview pane resources. "
       "Affects interpretation of relative links. "
       "Supports variable expansion ($PWD, $HOME, $XDG_DOCUMENTS_DIR)." },
 
+    { "preview_max_size",
+      setting_value_type{ 67108864 },
+      "Documents larger than this (bytes) are not rendered until requested. 0 disables." },
+
     { "preview_show_extra_info",
       setting_value_type{ false },
       "Show extra information when the document cannot be rendered." },
@@ -89,6 +167,10 @@ class PreviewConfig {
       setting_value_type{ false },
       "Synchronize zoom changes between Preview and Editor" },
 
+    { "sniff_txt_files",
+      setting_value_type{ true },
+      "Show .txt files that do not look like Markdown or prose (e.g., logs) as plain text." },
+
     { "terminal_command",
       setting_value_type{ std::string{ "xdg-terminal-exec --working-directory=%d" } },
       "Command to launch a terminal. %d = current document directory." },
@@ -105,6 +187,11 @@ class PreviewConfig {
       setting_value_type{ 15 },
       "Delay (ms) before first preview update after a change." },
 
+    { "webview_pool_size",
+      setting_value_type{ 1 },
+      "Number of recently shown documents that keep their own preview page, "
+      "so switching back is instant. 1 disables." },
+
     { "webview_resize_buffer",
       setting_value_type{ 0 },
       "Extra pixels to add when expanding the preview pane to avoid flicker." },
@@ -112,19 +199,38 @@ class PreviewConfig {
   // clang-format on
 
  public:
+  // Adds a setting at runtime, e.g. from a tweak.  The typed form returns a
+  // handle for reading it.
+  template <SettingValue T>
+  static Setting<T> registerSetting(const char *key, T default_value, const char *help) {
+    return Setting<T>{ typename Setting<T>::Index{}, addSetting(key, default_value, help) };
+  }
   static void
   registerSetting(const char *key, setting_value_type default_value, const char *help) {
-    // Extend the master table so the GUI sees it
-    setting_defs_.push_back({ key, default_value, help });
+    addSetting(key, std::move(default_value), help);
+  }
 
-    // Insert into runtime maps
-    auto &cfg = instance();
-    cfg.settings_[key] = default_value;
-    cfg.help_texts_[key] = help;
+  // Index of key in the value array; the type must match its default.
+  template <SettingValue T>
+  static std::size_t indexOf(std::string_view key) {
+    for (std::size_t i = 0; i < setting_defs_.size(); ++i) {
+      if (setting_defs_[i].key == key) {
+        return std::holds_alternative<T>(setting_defs_[i].default_value) ? i : kNoIndex;
+      }
+    }
+    return kNoIndex;
   }
 
-  std::unordered_map<std::string, setting_value_type> settings_;
-  std::unordered_map<std::string, std::string> help_texts_;
+  // All settings, in the order they were added
+  std::size_t size() const noexcept {
+    return values_.size();
+  }
+  const char *keyAt(std::size_t index) const {
+    return setting_defs_[index].key;
+  }
+  const setting_value_type &valueAt(std::size_t index) const {
+    return values_[index];
+  }
 
   bool load();
   bool save() const;
@@ -132,10 +238,26 @@ class PreviewConfig {
   // Builds config UI and hooks Apply/OK
   GtkWidget *buildConfigWidget(GtkDialog *dialog);
 
+  // Values are read from worker threads too (converters, exports); they are
+  // written only on the main thread, under values_mutex_.  Main-thread reads
+  // of the array itself (valueAt(), the dialog) need no lock.
+  template <SettingValue T>
+  T get(const Setting<T> &setting) const {
+    std::shared_lock lock(values_mutex_);
+    if (setting.index_ < values_.size()) {
+      if (auto val = std::get_if<T>(&values_[setting.index_])) {
+        return *val;
+      }
+    }
+    return T{};
+  }
+
+  // By name, for keys known only at runtime
   template <typename T>
   T get(const std::string &key, T default_val = {}) const {
-    if (auto it = settings_.find(key); it != settings_.end()) {
-      if (auto val = std::get_if<T>(&it->second)) {
+    std::shared_lock lock(values_mutex_);
+    if (auto it = index_.find(key); it != index_.end()) {
+      if (auto val = std::get_if<T>(&values_[it->second])) {
         return *val;
       }
     }
@@ -144,12 +266,23 @@ class PreviewConfig {
 
   template <typename T>
   void set(const std::string &key, const T &value) {
-    settings_[key] = value;
+    if (auto it = index_.find(key); it != index_.end()) {
+      std::unique_lock lock(values_mutex_);
+      values_[it->second] = value;
+    } else {
+      addSetting(key.c_str(), value, "");
+    }
+    ++generation_;
+  }
+
+  // Changes whenever a value may have changed; for caching derived values.
+  std::uint64_t generation() const noexcept {
+    return generation_.load(std::memory_order_relaxed);
   }
 
   std::string getHelp(const std::string &key) const {
-    if (auto it = help_texts_.find(key); it != help_texts_.end()) {
-      return it->second;
+    if (auto it = index_.find(key); it != index_.end()) {
+      return setting_defs_[it->second].help;
     }
     return {};
   }
@@ -158,11 +291,14 @@ class PreviewConfig {
     return config_path_;
   }
 
-  // for change signal
-  using Callback = std::function<void()>;
+  // Keys whose values changed since the previous notification
+  using Changes = std::vector<std::string_view>;
+  using Callback = std::function<void(const Changes &)>;
 
-  void connectChanged(Callback cb) {
-    listeners_.push_back(std::move(cb));
+  // Calls cb on Apply/OK with the changed keys that match patterns.  A pattern
+  // is a key, or a prefix ending in '*' ("tweakui/column_markers/*").
+  void subscribe(std::vector<std::string> patterns, Callback cb) {
+    subscriptions_.push_back({ std::move(patterns), std::move(cb) });
   }
 
  private:
@@ -176,14 +312,24 @@ class PreviewConfig {
   }
 
  private:
-  // for change signal
-  std::vector<Callback> listeners_;
+  struct Subscription {
+    std::vector<std::string> patterns;
+    Callback callback;
+  };
+  std::vector<Subscription> subscriptions_;
+  std::vector<setting_value_type> notified_;  // values as of the last notification
 
-  void emitChanged() {
-    for (auto &cb : listeners_) {
-      cb();
-    }
-  }
+  void emitChanged();
+
+  static constexpr std::size_t kNoIndex = static_cast<std::size_t>(-1);
+
+  static std::size_t
+  addSetting(const char *key, setting_value_type default_value, const char *help);
+
+  // Parallel to setting_defs_; handles index into values_
+  std::vector<setting_value_type> values_;
+  std::unordered_map<std::string, std::size_t> index_;
+  mutable std::shared_mutex values_mutex_;  // guards values_ and index_
 
   void onDialogResponse(GtkDialog *dialog, gint response_id);
   GtkListStore *createConfigModel();
@@ -192,4 +338,37 @@ class PreviewConfig {
 
   std::filesystem::path config_path_;
   std::string config_file_;
+  std::atomic<std::uint64_t> generation_{ 0 };
 };
+
+template <SettingValue T>
+Setting<T>::Setting(std::string_view key) : index_(PreviewConfig::indexOf<T>(key)) {}
+
+// Built-in settings.  Defined after setting_defs_, so it is initialized first.
+namespace Settings {
+inline const Setting<std::string> kAutoExportDir{ "auto_export_dir" };
+inline const Setting<int> kBatchExportExternalJobs{ "batch_export_external_jobs" };
+inline const Setting<int> kBatchExportJobs{ "batch_export_jobs" };
+inline const Setting<bool> kCodeHighlight{ "code_highlight" };
+inline const Setting<bool> kDisablePreviewCtrlWheelZoom{ "disable_preview_ctrl_wheel_zoom" };
+inline const Setting<bool> kExportInlineOutsideFolder{ "export_inline_outside_folder" };
+inline const Setting<bool> kExportSelfContained{ "export_self_contained" };
+inline const Setting<std::string> kFileManagerCommand{ "file_manager_command" };
+inline const Setting<int> kHeadersIncompleteMax{ "headers_incomplete_max" };
+inline const Setting<bool> kKeybindingBehaviorStrict{ "keybinding_behavior_strict" };
+inline const Setting<int> kMarkdownMaxSize{ "markdown_max_size" };
+inline const Setting<int> kMarkdownParallelMinSize{ "markdown_parallel_min_size" };
+inline const Setting<std::string> kMarkdownSourcepos{ "markdown_sourcepos" };
+inline const Setting<std::string> kPreviewBasePath{ "preview_base_path" };
+inline const Setting<int> kPreviewMaxSize{ "preview_max_size" };
+inline const Setting<bool> kPreviewShowExtraInfo{ "preview_show_extra_info" };
+inline const Setting<double> kPreviewZoomDefault{ "preview_zoom_default" };
+inline const Setting<bool> kPreviewZoomSync{ "preview_zoom_sync" };
+inline const Setting<bool> kSniffTxtFiles{ "sniff_txt_files" };
+inline const Setting<std::string> kTerminalCommand{ "terminal_command" };
+inline const Setting<std::string> kThemeMode{ "theme_mode" };
+inline const Setting<int> kUpdateCooldown{ "update_cooldown" };
+inline const Setting<int> kUpdateMinDelay{ "update_min_delay" };
+inline const Setting<int> kWebviewPoolSize{ "webview_pool_size" };
+inline const Setting<int> kWebviewResizeBuffer{ "webview_resize_buffer" };
+}  // namespace Settings
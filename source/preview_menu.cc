@@ -8,6 +8,7 @@
 #include <gtk/gtk.h>
 #include <msgwindow.h>
 
+#include "batch_export.h"
 #include "document_geany.h"
 #include "preview_config.h"
 #include "preview_context.h"
@@ -129,6 +130,11 @@ void PreviewMenu::onExportToPdf(GtkMenuItem *, gpointer user_data) {
   });
 }
 
+void PreviewMenu::onBatchExport(GtkMenuItem *, gpointer user_data) {
+  auto &ctx = PreviewContext::instance();
+  BatchExport::instance().showDialog(GTK_WINDOW(ctx.geany_data_->main_widgets->window));
+}
+
 void PreviewMenu::onPrint(GtkMenuItem *, gpointer user_data) {
   auto &ctx = PreviewContext::instance();
   auto &wv = WebView::instance();
@@ -35,6 +35,7 @@ class PreviewMenu {
 
   static void onExportToHtml(GtkMenuItem *, gpointer user_data);
   static void onExportToPdf(GtkMenuItem *, gpointer user_data);
+  static void onBatchExport(GtkMenuItem *, gpointer user_data);
   static void onPrint(GtkMenuItem *, gpointer user_data);
   static void onOpenConfigFolder(GtkMenuItem *, gpointer user_data);
   static void onPreferences(GtkMenuItem *, gpointer user_data);
@@ -56,6 +57,10 @@ class PreviewMenu {
       "Export the current preview to a PDF file",
       onExportToPdf },
 
+    { "Batch Export…",
+      "Export open documents or a folder of documents to HTML or PDF",
+      onBatchExport },
+
     { nullptr, nullptr, nullptr }, // separator
 
     { "Print…",
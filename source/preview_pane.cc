@@ -5,25 +5,32 @@
 
 #include <algorithm>
 #include <filesystem>
-#include <fstream>
 #include <string>
 #include <unordered_map>
 #include <unordered_set>
 
 #include <gtk/gtk.h>
+#include <msgwindow.h>
 #include <webkit2/webkit2.h>
 
+#include "code_highlighter.h"
 #include "converter_preprocessor.h"
 #include "converter_registrar.h"
 #include "default_css.h"
 #include "document_geany.h"
 #include "document_local.h"
+#include "document_snapshot.h"
+#include "export_html.h"
+#include "fountain_pdf.h"
+#include "offscreen_pdf.h"
 #include "preview_config.h"
 #include "preview_context.h"
-#include "renderers_pdf.h"
+#include "text_sniffer.h"
 #include "util/file_utils.h"
 #include "util/gtk_utils.h"
 #include "util/string_utils.h"
+#include "util/main_thread.h"
+#include "util/thread_pool.h"
 #include "util/xdg_utils.h"
 #include "webview.h"
 
@@ -67,22 +74,38 @@ PreviewPane::PreviewPane() {
 
   safeReparentWebView(page_box_);
 
-  // config callback
-  cfg.connectChanged([this]() {
-    auto &wv = WebView::instance();
-    wv.reset();
-    connectWebViewSignals();
+  // Settings read once per view or baked into the rendered page; the rest
+  // (tweaks, export and editor settings) are read when used
+  cfg.subscribe(
+      { "code_highlight",
+        "headers_incomplete_max",
+        "markdown_*",
+        "preview_base_path",
+        "preview_max_size",
+        "preview_show_extra_info",
+        "preview_zoom_default",
+        "sniff_txt_files",
+        "theme_mode",
+        "webview_pool_size" },
+      [this](const PreviewConfig::Changes &) {
+        DocumentGeany::invalidateAll();
+        parked_views_.clear();
 
-    DocumentLocal local_doc("/somewhere-out-there/over-the-rainbow.ftn");
-    initWebView(local_doc);
+        auto &wv = WebView::instance();
+        wv.reset();
+        connectWebViewSignals();
 
-    if (GeanyDocument *doc = document_get_current()) {
-      DocumentGeany document(doc);
-      triggerUpdate(document);
-    }
+        DocumentLocal local_doc("/somewhere-out-there/over-the-rainbow.ftn");
+        initWebView(local_doc);
 
-    safeReparentWebView(page_box_);
-  });
+        if (GeanyDocument *doc = document_get_current()) {
+          DocumentGeany document(doc);
+          triggerUpdate(document);
+        }
+
+        safeReparentWebView(page_box_);
+      }
+  );
 
   sidebar_switch_page_handler_id_ = g_signal_connect(
       sidebar_notebook_,
@@ -165,14 +188,20 @@ GtkWidget *PreviewPane::widget() const {
 }
 
 PreviewPane &PreviewPane::initWebView(const Document &document) {
+  auto &wv = WebView::instance();
+  startNavigation();
+  view_file_ = document.filePath();
+  wv.bindCurrent(view_file_);
+  parked_views_.erase(view_file_);
+
   previous_base_uri_.clear();
   previous_key_.clear();
   previous_theme_.clear();
+  rendered_digest_.reset();
 
   const std::string base_uri = calculateBaseUri(document);
   root_id_ = "geany-preview-" + StringUtils::randomHex(8);
 
-  auto &wv = WebView::instance();
   wv.loadHtml("", base_uri, root_id_, nullptr);
 
   clearAndReloadCss();
@@ -186,24 +215,31 @@ void PreviewPane::connectWebViewSignals() {
   init_handler_id_ = g_signal_connect(
       wv.widget(),
       "load-changed",
-      G_CALLBACK(+[](WebKitWebView *, WebKitLoadEvent e, gpointer user_data) {
+      G_CALLBACK(+[](WebKitWebView *view, WebKitLoadEvent e, gpointer user_data) {
         auto *self = static_cast<PreviewPane *>(user_data);
-        auto &wv = WebView::instance();
         if (e == WEBKIT_LOAD_FINISHED) {
+          self->rendered_digest_.reset();
           self->scheduleUpdate();
-          g_signal_handler_disconnect(wv.widget(), self->init_handler_id_);
+          // Connected to this view, which may no longer be the current one
+          g_signal_handler_disconnect(view, self->init_handler_id_);
           self->init_handler_id_ = 0;
         }
       }),
       this
   );
 
+  connectHealthCheck();
+}
+
+void PreviewPane::connectHealthCheck() {
+  auto &wv = WebView::instance();
   g_signal_connect(
       wv.widget(),
       "load-changed",
-      G_CALLBACK(+[](WebKitWebView *, WebKitLoadEvent e, gpointer user_data) {
+      G_CALLBACK(+[](WebKitWebView *view, WebKitLoadEvent e, gpointer user_data) {
         auto *self = static_cast<PreviewPane *>(user_data);
-        if (e == WEBKIT_LOAD_FINISHED) {
+        // checkHealth() looks at the current view; parked ones keep their state
+        if (e == WEBKIT_LOAD_FINISHED && GTK_WIDGET(view) == WebView::instance().widget()) {
           self->checkHealth();
         }
       }),
@@ -268,8 +304,8 @@ PreviewPane &PreviewPane::scheduleUpdate() {
   auto &cfg = PreviewConfig::instance();
 
   gint64 now = g_get_monotonic_time() / 1000;
-  gint64 update_cooldown_ms_ = cfg.get<int>("update_cooldown");
-  gint64 update_min_delay_ = cfg.get<int>("update_min_delay");
+  gint64 update_cooldown_ms_ = cfg.get(Settings::kUpdateCooldown);
+  gint64 update_min_delay_ = cfg.get(Settings::kUpdateMinDelay);
 
   gint64 delay_ms =
       std::max(update_min_delay_, update_cooldown_ms_ - (now - last_update_time_));
@@ -279,6 +315,11 @@ PreviewPane &PreviewPane::scheduleUpdate() {
       [](gpointer data) -> gboolean {
         auto *self = static_cast<PreviewPane *>(data);
         DocumentGeany document(document_get_current());
+        self->switchView(document.filePath());
+        if (self->unchangedSinceRender(document)) {
+          self->update_pending_ = false;
+          return G_SOURCE_REMOVE;
+        }
         self->triggerUpdate(document);
         return G_SOURCE_REMOVE;
       },
@@ -287,6 +328,21 @@ PreviewPane &PreviewPane::scheduleUpdate() {
   return *this;
 }
 
+bool PreviewPane::unchangedSinceRender(const Document &document) const {
+  if (!rendered_digest_ || !webview_healthy_ || document.filePath() != rendered_file_) {
+    return false;
+  }
+  if (themeMode() != previous_theme_) {
+    return false;
+  }
+  // Generations are unique across documents, so a stale one never matches
+  std::uint64_t generation = document.textGeneration();
+  if (generation && generation == rendered_generation_) {
+    return true;
+  }
+  return document.computeHash() == *rendered_digest_;
+}
+
 void PreviewPane::triggerUpdate(const Document &document) {
   update(document);
   last_update_time_ = g_get_monotonic_time() / 1000;
@@ -297,89 +353,236 @@ void PreviewPane::exportHtmlToFileAsync(
     const std::filesystem::path &dest,
     std::function<void(bool)> callback
 ) {
-  auto &wv = WebView::instance();
-  wv.getDomSnapshot(
-      root_id_, [dest, cb = std::move(callback)](const std::string &content_html) {
-        bool success = false;
-        if (!content_html.empty()) {
-          std::error_code ec;
-          if (!dest.parent_path().empty()) {
-            std::filesystem::create_directories(dest.parent_path(), ec);
-          }
-          std::ofstream out(dest, std::ios::binary | std::ios::trunc);
-          if (out) {
-            out << "<!doctype html>\n<html>\n<head>\n<meta charset=\"utf-8\">\n</head>\n"
-                << "<body>\n"
-                << content_html << "\n</body>\n</html>\n";
-            out.flush();
-            out.close();
-            success = out.good();
-          }
-        }
-        cb(success);
+  DocumentGeany document(document_get_current());
+
+  // The preview's own render when the text hasn't changed since, otherwise a
+  // fresh conversion of a snapshot on the worker
+  std::shared_ptr<const std::string> html = cachedRender(document);
+  std::shared_ptr<const DocumentSnapshot> snapshot;
+  std::string_view key;
+  if (html) {
+    key = last_render_.key;
+  } else {
+    snapshot = document.snapshot();
+  }
+  auto &cfg = PreviewConfig::instance();
+
+  std::filesystem::path source = document.filePath();
+  std::string title = source.empty() ? "untitled" : source.stem().string();
+  std::filesystem::path asset_dir;
+  if (cfg.get(Settings::kExportSelfContained)) {
+    asset_dir = source.parent_path();
+  }
+
+  ThreadPool::instance().post([this,
+                               dest,
+                               html = std::move(html),
+                               snapshot = std::move(snapshot),
+                               key,
+                               theme = themeMode(),
+                               title = std::move(title),
+                               asset_dir = std::move(asset_dir),
+                               callback = std::move(callback)]() {
+    bool ok = false;
+    try {
+      std::string rendered;
+      std::string_view body = html ? std::string_view{ *html } : std::string_view{};
+      std::string_view used = key;
+      if (snapshot) {
+        rendered = exportHtml(*snapshot, &used);
+        body = rendered;
       }
-  );
+      ok = ExportHtml::writePage(
+          dest, body, title, ExportHtml::stylesheet(used, theme), asset_dir
+      );
+    } catch (...) {
+      // Reported as a failed export
+    }
+
+    MainThread::instance().post([callback, ok] { callback(ok); });
+  });
+}
+
+std::shared_ptr<const std::string> PreviewPane::cachedRender(const Document &document) const {
+  if (!last_render_.html || last_render_.file != document.filePath() ||
+      last_render_.config_generation != PreviewConfig::instance().generation()) {
+    return nullptr;
+  }
+
+  std::uint64_t generation = document.textGeneration();
+  if ((generation && generation == last_render_.text_generation) ||
+      last_render_.digest == document.computeHash()) {
+    return last_render_.html;
+  }
+  return nullptr;
 }
 
 void PreviewPane::exportPdfToFileAsync(
     const std::filesystem::path &dest,
     std::function<void(bool)> callback
 ) {
+  if (pdf_export_) {
+    pdf_progress_.present();
+    callback(false);
+    return;
+  }
+
   DocumentGeany document(document_get_current());
 
-  // Ensure parent directories exist
-  std::error_code ec;
-  if (!dest.parent_path().empty()) {
-    std::filesystem::create_directories(dest.parent_path(), ec);  // best-effort
-  }
+  auto job = std::make_shared<PdfExport>();
+  job->dest = dest;
+  job->callback = std::move(callback);
+  pdf_export_ = job;
+
+  std::string name = dest.filename().string();
+  pdf_progress_.start("Export to PDF", [this] { cancelPdfExport(); });
+  pdf_progress_.setProgress(-1.0);
 
 #ifdef HAVE_PODOFO
-  // Fountain with PoDoFo
+  // Fountain with PoDoFo, laid out and written on the worker
   if (registrar_.getConverterKey(document) == "fountain") {
-    bool ok = Fountain::ftn2pdf(dest.string(), document.text());
-    callback(ok);
+    pdf_progress_.setStatus("Writing " + name + "…");
+    job->writing = true;
+    job->pulse_source = g_timeout_add(
+        kPulseInterval,
+        [](gpointer) -> gboolean {
+          instance().pdf_progress_.setProgress(-1.0);
+          return G_SOURCE_CONTINUE;
+        },
+        nullptr
+    );
+
+    ThreadPool::instance().post([snapshot = document.snapshot(), job]() {
+      bool ok = false;
+      try {
+        ok = FountainPdf::instance().write(*snapshot, job->dest, job->cancelled);
+      } catch (...) {
+        // Reported as a failed export
+      }
+      MainThread::instance().post([job, ok] { instance().finishPdfExport(job, ok); });
+    });
     return;
   }
 #endif
 
-  // Fallback: WebKit print-to-PDF
-  GtkPrintSettings *settings = gtk_print_settings_new();
-  gtk_print_settings_set(settings, GTK_PRINT_SETTINGS_PRINTER, "Print to File");
-  gtk_print_settings_set(settings, GTK_PRINT_SETTINGS_OUTPUT_FILE_FORMAT, "pdf");
-
-  if (char *uri = g_filename_to_uri(dest.c_str(), nullptr, nullptr)) {
-    gtk_print_settings_set(settings, GTK_PRINT_SETTINGS_OUTPUT_URI, uri);
-    g_free(uri);
+  // WebKit print-to-PDF on a view of its own, from the same render as HTML export
+  std::shared_ptr<const std::string> html = cachedRender(document);
+  std::shared_ptr<const DocumentSnapshot> snapshot;
+  std::string_view key;
+  if (html) {
+    key = last_render_.key;
   } else {
-    g_object_unref(settings);
-    callback(false);
-    return;
+    snapshot = document.snapshot();
   }
 
-  auto &wv = WebView::instance();
-  WebKitPrintOperation *op = webkit_print_operation_new(WEBKIT_WEB_VIEW(wv.widget()));
-  webkit_print_operation_set_print_settings(op, settings);
+  std::filesystem::path source = document.filePath();
+  std::string title = source.empty() ? "untitled" : source.stem().string();
+  pdf_progress_.setStatus("Rendering " + name + "…");
+
+  ThreadPool::instance().post([this,
+                               job,
+                               base_uri = calculateBaseUri(document),
+                               html = std::move(html),
+                               snapshot = std::move(snapshot),
+                               key,
+                               theme = themeMode(),
+                               title = std::move(title)]() {
+    auto page = std::make_shared<std::string>();
+    bool ok = true;
+    try {
+      if (!job->cancelled) {
+        std::string converted;
+        std::string_view body = html ? std::string_view{ *html } : std::string_view{};
+        std::string_view used = key;
+        if (snapshot) {
+          converted = exportHtml(*snapshot, &used);
+          body = converted;
+        }
+        *page = ExportHtml::page(body, title, ExportHtml::stylesheet(used, theme));
+      }
+    } catch (...) {
+      ok = false;
+    }
 
-  GtkPageSetup *page_setup = gtk_page_setup_new();
-  webkit_print_operation_set_page_setup(op, page_setup);
+    MainThread::instance().post([job, base_uri, page, ok] {
+      if (ok) {
+        instance().printPdf(job, *page, base_uri);
+      } else {
+        instance().finishPdfExport(job, false);
+      }
+    });
+  });
+}
 
-  // Connect to the "finished" signal to know when printing completes
-  g_signal_connect(
-      op,
-      "finished",
-      G_CALLBACK(+[](WebKitPrintOperation *, gboolean success, gpointer user_data) {
-        auto *cb_ptr = static_cast<std::function<void(bool)> *>(user_data);
-        (*cb_ptr)(success);
-        delete cb_ptr;
-      }),
-      new std::function<void(bool)>(std::move(callback))
+void PreviewPane::printPdf(
+    std::shared_ptr<PdfExport> job,
+    const std::string &page,
+    const std::string &base_uri
+) {
+  if (job != pdf_export_) {
+    return;  // cancelled while rendering
+  }
+
+  auto &wv = WebView::instance();
+  OffscreenPdf::Options options;
+  options.context = wv.context();
+  options.settings = wv.settings();
+  options.progress = [this, name = job->dest.filename().string()](
+                         OffscreenPdf::Stage stage, std::uintmax_t bytes
+                     ) {
+    if (stage == OffscreenPdf::Stage::Loading) {
+      pdf_progress_.setStatus("Laying out " + name + "…");
+      pdf_progress_.setProgress(-1.0);
+    } else {
+      gchar *size = g_format_size(bytes);
+      pdf_progress_.setStatus("Writing " + name + "…");
+      pdf_progress_.setProgress(-1.0, size);
+      g_free(size);
+    }
+  };
+
+  job->print_id = OffscreenPdf::print(
+      page,
+      base_uri,
+      job->dest,
+      [this, job](bool ok) { finishPdfExport(job, ok); },
+      std::move(options)
   );
+}
+
+void PreviewPane::cancelPdfExport() {
+  auto job = pdf_export_;
+  if (!job) {
+    return;
+  }
+
+  job->cancelled = true;
+  if (job->print_id || job->writing) {
+    // Ends through finishPdfExport() once the output is discarded
+    pdf_progress_.setStatus("Cancelling…");
+    if (job->print_id) {
+      OffscreenPdf::cancel(job->print_id);
+    }
+  } else {
+    finishPdfExport(job, false);
+  }
+}
 
-  webkit_print_operation_print(op);
+void PreviewPane::finishPdfExport(const std::shared_ptr<PdfExport> &job, bool ok) {
+  if (job != pdf_export_) {
+    return;
+  }
 
-  g_object_unref(settings);
-  g_object_unref(page_setup);
-  g_object_unref(op);
+  pdf_export_.reset();
+  if (job->pulse_source) {
+    g_source_remove(job->pulse_source);
+  }
+  pdf_progress_.close();
+  if (job->cancelled) {
+    msgwin_status_add("Preview: PDF export cancelled.");
+  } else {
+    job->callback(ok);
+  }
 }
 
 bool PreviewPane::canPreviewFile(const Document &doc) const {
@@ -415,16 +618,25 @@ void PreviewPane::safeReparentWebView(GtkWidget *new_parent) {
   g_object_unref(wv);
 }
 
-std::string PreviewPane::generateHtml(const Document &document) const {
+std::string PreviewPane::generateHtml(
+    const Document &document,
+    std::string *sourcepos,
+    std::string_view *key
+) const {
   auto &cfg = PreviewConfig::instance();
-  ConverterPreprocessor pre(document, cfg.get<int>("headers_incomplete_max"));
 
-  Converter *converter = nullptr;
-  if (!pre.type().empty()) {
-    converter = registrar_.getConverter(pre.type());
+  int max_size = cfg.get(Settings::kPreviewMaxSize);
+  if (max_size > 0 && document.segments().size() > static_cast<std::size_t>(max_size) &&
+      !force_render_files_.contains(document.filePath())) {
+    return largeFileNotice(document);
   }
-  if (!converter) {
-    converter = registrar_.getConverter(document);
+
+  auto &pre = preprocessor_;
+  pre.setMaxIncomplete(cfg.get(Settings::kHeadersIncompleteMax));
+  pre.preprocess(document);
+
+  if (Converter *converter = selectConverter(document, pre, key)) {
+    return renderBody(*converter, pre, sourcepos);
   }
 
   auto normalizedType = [](std::string_view t) {
@@ -438,14 +650,12 @@ std::string PreviewPane::generateHtml(const Document &document) const {
   };
 
   auto &ctx = PreviewContext::instance();
-  if (converter) {
-    return pre.headersToHtml() + std::string{ converter->toHtml(pre.body()) };
-  } else if (ctx.geany_plugin_) {
+  if (ctx.geany_plugin_) {
     std::string html = "<tt>";
     html += std::string{ ctx.geany_plugin_->info->name } + " ";
     html += std::string{ ctx.geany_plugin_->info->version } + "</br>";
     html += "&nbsp;&nbsp;&nbsp;";
-    if (cfg.get<bool>("preview_show_extra_info")) {
+    if (cfg.get(Settings::kPreviewShowExtraInfo)) {
       if (!document.filetypeName().empty()) {
         html += document.filetypeName() + ", " + document.encodingName();
       } else {
@@ -462,6 +672,120 @@ std::string PreviewPane::generateHtml(const Document &document) const {
   }
 }
 
+std::string PreviewPane::exportHtml(const Document &document, std::string_view *key) const {
+  ConverterPreprocessor pre;
+  pre.setMaxIncomplete(PreviewConfig::instance().get(Settings::kHeadersIncompleteMax));
+  pre.preprocess(document);
+
+  Converter *converter = selectConverter(document, pre, key);
+  return converter ? renderBody(*converter, pre, nullptr) : std::string{};
+}
+
+Converter *PreviewPane::selectConverter(
+    const Document &document,
+    const ConverterPreprocessor &pre,
+    std::string_view *key
+) const {
+  std::string_view used;
+  Converter *converter = nullptr;
+  if (!pre.type().empty()) {
+    used = registrar_.getConverterKey(pre.type());
+    converter = registrar_.getConverter(used);
+  }
+  if (!converter) {
+    used = routeConverterKey(document, pre.body());
+    converter = registrar_.getConverter(used);
+  }
+  if (key) {
+    *key = converter ? used : std::string_view{};
+  }
+  return converter;
+}
+
+std::string PreviewPane::renderBody(
+    Converter &converter,
+    const ConverterPreprocessor &pre,
+    std::string *sourcepos
+) const {
+  std::string html = pre.headersToHtml();
+  auto body = converter.toHtmlSegmented(pre.body());
+
+  // Source positions count elements from the start of the converter's output
+  bool container = sourcepos && !converter.sourcepos().empty();
+  if (container) {
+    html += "<div data-preview-body>";
+  }
+  if (PreviewConfig::instance().get(Settings::kCodeHighlight)) {
+    CodeHighlighter::instance().appendHighlighted(html, body);
+  } else {
+    html += body;
+  }
+  if (container) {
+    html += "</div>";
+    *sourcepos = converter.sourcepos();
+  }
+  return html;
+}
+
+std::string_view PreviewPane::routeConverterKey(
+    const Document &document,
+    const TextSegments &body
+) const {
+  std::string_view key = registrar_.getConverterKey(document);
+  if (key != "markdown") {
+    return key;
+  }
+
+  // Keep huge files out of the Markdown parser
+  auto &cfg = PreviewConfig::instance();
+  int max_size = cfg.get(Settings::kMarkdownMaxSize);
+  if (max_size > 0 && body.size() > static_cast<std::size_t>(max_size)) {
+    return "plaintext";
+  }
+
+  // .txt maps to Markdown; logs and data dumps read better preformatted
+  std::string sample;
+  if (cfg.get(Settings::kSniffTxtFiles) &&
+      StringUtils::toLower(document.filetypeName()) != "markdown" &&
+      StringUtils::toLower(std::filesystem::path(document.filePath()).extension().string()) ==
+          ".txt" &&
+      !TextSniffer::looksLikeMarkdown(body.prefix(TextSniffer::kSampleSize, sample))) {
+    return "plaintext";
+  }
+
+  return key;
+}
+
+std::string PreviewPane::largeFileNotice(const Document &document) const {
+  auto mib = [](std::size_t bytes) { return std::to_string((bytes + (1 << 20) - 1) >> 20); };
+
+  std::string html = "<p class=\"preview-notice\">Preview skipped: document is ";
+  html += mib(document.segments().size()) + " MiB (limit ";
+  html += mib(PreviewConfig::instance().get(Settings::kPreviewMaxSize)) + " MiB).";
+
+  if (!document.filePath().empty()) {
+    gchar *escaped = g_uri_escape_string(document.filePath().c_str(), nullptr, false);
+    html += " <a href=\"geany-preview:force-render?";
+    html += escaped;
+    html += "\">Render anyway</a>";
+    g_free(escaped);
+  }
+  html += "</p>";
+  return html;
+}
+
+void PreviewPane::forceRender(const std::string &file) {
+  force_render_files_.insert(file);
+
+  DocumentGeany current(document_get_current());
+  if (current.filePath() == file) {
+    triggerUpdate(current);
+  } else {
+    DocumentLocal local(file);
+    initWebView(local);
+  }
+}
+
 namespace {
 std::string toUri(const std::filesystem::path &path, const std::string &fallback) {
   std::filesystem::path p = path;
@@ -481,9 +805,19 @@ std::string toUri(const std::filesystem::path &path, const std::string &fallback
 }
 }  // namespace
 
-std::string PreviewPane::calculateBaseUri(const Document &document) const {
+const std::string &PreviewPane::calculateBaseUri(const Document &document) const {
+  auto &cfg = PreviewConfig::instance();
+  auto &rc = document.renderContext();
+  if (rc.base_uri.empty() || rc.base_uri_generation != cfg.generation()) {
+    rc.base_uri = computeBaseUri(document);
+    rc.base_uri_generation = cfg.generation();
+  }
+  return rc.base_uri;
+}
+
+std::string PreviewPane::computeBaseUri(const Document &document) const {
   auto &cfg = PreviewConfig::instance();
-  std::string config_path = cfg.get<std::string>("preview_base_path", "sandbox");
+  std::string config_path = cfg.get(Settings::kPreviewBasePath);
   config_path = config_path.empty() ? "sandbox" : XdgUtils::expandEnvVars(config_path);
 
   std::string default_base_uri = toUri(config_path, "file:///sandbox/");
@@ -501,40 +835,107 @@ std::string PreviewPane::calculateBaseUri(const Document &document) const {
   return toUri(dir_path, default_base_uri);
 }
 
+void PreviewPane::switchView(const std::string &file) {
+  auto &cfg = PreviewConfig::instance();
+  int pool_size = cfg.get(Settings::kWebviewPoolSize);
+  if (pool_size <= 1 || file == view_file_) {
+    return;
+  }
+
+  parked_views_[view_file_] = { root_id_,
+                                previous_base_uri_,
+                                previous_key_,
+                                previous_theme_,
+                                webview_healthy_,
+                                rendered_file_,
+                                rendered_digest_ };
+
+  auto &wv = WebView::instance();
+  auto result = wv.switchTo(file, static_cast<std::size_t>(pool_size));
+  view_file_ = file;
+
+  auto it = parked_views_.find(file);
+  if (result == WebView::ViewSwitch::Reused && it != parked_views_.end()) {
+    auto &state = it->second;
+    root_id_ = std::move(state.root_id);
+    previous_base_uri_ = std::move(state.base_uri);
+    previous_key_ = std::move(state.key);
+    previous_theme_ = std::move(state.theme);
+    webview_healthy_ = state.healthy;
+    rendered_file_ = std::move(state.rendered_file);
+    rendered_digest_ = state.rendered_digest;
+  } else {
+    // Blank or stale page: the next update loads it in full and injects CSS
+    root_id_ = "geany-preview-" + StringUtils::randomHex(8);
+    previous_base_uri_.clear();
+    previous_key_.clear();
+    previous_theme_.clear();
+    webview_healthy_ = true;
+    rendered_digest_.reset();
+    if (result == WebView::ViewSwitch::Created) {
+      connectHealthCheck();
+    }
+  }
+
+  std::erase_if(parked_views_, [&](const auto &kv) {
+    return kv.first == file || !wv.hasView(kv.first);
+  });
+}
+
 PreviewPane &PreviewPane::update(const Document &document) {
   auto &cfg = PreviewConfig::instance();
-  std::string html = generateHtml(document);
+  switchView(document.filePath());
+  std::string sourcepos;
+  std::string_view converted;
+  auto html =
+      std::make_shared<const std::string>(generateHtml(document, &sourcepos, &converted));
 
   // load new css on document type change
-  auto key = registrar_.getConverterKey(document);
+  std::string_view key = registrar_.getConverterKey(document);
   if (key != previous_key_) {
-    addWatchIfNeeded(cfg.configDir() / std::string{ key + ".css" });
     previous_key_ = key;
+    addWatchIfNeeded(cfg.configDir() / (previous_key_ + ".css"));
     clearAndReloadCss();
   }
 
-  auto theme = cfg.get<std::string>("theme_mode", "system");
-  if (theme != previous_theme_) {
+  if (themeMode() != previous_theme_) {
     injectCssTheme();
   }
 
-  auto file = document.filePath();
-  std::string base_uri = calculateBaseUri(document);
+  const std::string &file = document.filePath();
+  const std::string &base_uri = calculateBaseUri(document);
+  if (file != rendered_file_) {
+    startNavigation();
+  }
 
   auto &wv = WebView::instance();
   if (base_uri != previous_base_uri_) {
     previous_base_uri_ = base_uri;
-    wv.loadHtml(html, base_uri, root_id_, &scroll_by_file_[file]);
+    wv.loadHtml(*html, base_uri, root_id_, &scroll_by_file_[file], sourcepos);
   } else if (!webview_healthy_) {
-    wv.loadHtml(html, base_uri, root_id_, &scroll_by_file_[file]);
+    wv.loadHtml(*html, base_uri, root_id_, &scroll_by_file_[file], sourcepos);
     webview_healthy_ = true;
   } else {
-    wv.getScrollFraction([this, file, base_uri, html](double frac) {
+    wv.getScrollFraction([this, file, base_uri, html, sourcepos](double frac) {
       scroll_by_file_[file] = frac;
       auto &wv = WebView::instance();
-      wv.updateHtml(html, base_uri, root_id_, &scroll_by_file_[file]);
+      wv.updateHtml(*html, base_uri, root_id_, &scroll_by_file_[file], sourcepos);
     });
   }
+
+  document.resetDirtyRanges();
+  rendered_file_ = file;
+  rendered_digest_ = document.computeHash();
+  rendered_generation_ = document.textGeneration();
+
+  if (!converted.empty()) {
+    last_render_ = {
+      file, *rendered_digest_, rendered_generation_, cfg.generation(), std::move(html),
+      converted
+    };
+  } else {
+    last_render_ = {};
+  }
   return *this;
 }
 
@@ -592,9 +993,17 @@ PreviewPane &PreviewPane::clearAndReloadCss() {
   return *this;
 }
 
-PreviewPane &PreviewPane::injectCssTheme() {
+const std::string &PreviewPane::themeMode() const {
   auto &cfg = PreviewConfig::instance();
-  previous_theme_ = cfg.get<std::string>("theme_mode", "system");
+  if (theme_generation_ != cfg.generation() || theme_mode_.empty()) {
+    theme_mode_ = cfg.get(Settings::kThemeMode);
+    theme_generation_ = cfg.generation();
+  }
+  return theme_mode_;
+}
+
+PreviewPane &PreviewPane::injectCssTheme() {
+  previous_theme_ = themeMode();
 
   auto &wv = WebView::instance();
   if (previous_theme_ == "light") {
@@ -677,7 +1086,7 @@ void PreviewPane::onPanedMotion() {
   }
 
   auto &cfg = PreviewConfig::instance();
-  int resize_buffer = cfg.get<int>("webview_resize_buffer", 0);
+  int resize_buffer = cfg.get(Settings::kWebviewResizeBuffer);
   int width = gtk_widget_get_allocated_width(sidebar_notebook_);
 
   if (resize_buffer <= 0 || width <= 0) {
@@ -3,16 +3,24 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 
 #include <gtk/gtk.h>
 
+#include "converter_preprocessor.h"
 #include "converter_registrar.h"
 #include "document.h"
 #include "preview_config.h"
 #include "preview_context.h"
+#include "progress_dialog.h"
 #include "webview.h"
 
 class PreviewPane final {
@@ -43,17 +51,68 @@ class PreviewPane final {
   void
   exportHtmlToFileAsync(const std::filesystem::path &dest, std::function<void(bool)> callback);
 
+  // Prints on an offscreen view; the preview keeps updating meanwhile.  One
+  // export at a time, with a progress dialog that can cancel it; callback
+  // doesn't run for a cancelled export.
   void
   exportPdfToFileAsync(const std::filesystem::path &dest, std::function<void(bool)> callback);
+  void cancelPdfExport();
+  // On cleanup, once the worker pool has stopped
+  void releaseConverters() {
+    registrar_.releaseConverters();
+  }
 
   bool canPreviewFile(const Document &doc) const;
 
+  // Body HTML for exporting the document, without the preview_max_size limit.
+  // Safe to call from worker threads: settings are read under the config's
+  // lock and each thread has its own converters.  Empty if no converter
+  // handles it.  key is set to the key of the converter used, for the stylesheet.
+  std::string exportHtml(const Document &document, std::string_view *key = nullptr) const;
+
+  // Renders the file even if it exceeds preview_max_size.
+  void forceRender(const std::string &file);
+
+  // Bumped when the pane starts showing another page.  An async load takes a
+  // number from startNavigation() and drops its result if navigation() has
+  // moved on by the time it finishes.
+  std::uint64_t startNavigation() {
+    return ++navigation_;
+  }
+  std::uint64_t navigation() const {
+    return navigation_;
+  }
+
  private:
   void connectWebViewSignals();
+  void connectHealthCheck();
   void safeReparentWebView(GtkWidget *new_parent);
-  std::string generateHtml(const Document &document) const;
-  std::string calculateBaseUri(const Document &document) const;
+  // key is set when a converter produced the HTML (not a notice)
+  std::string generateHtml(
+      const Document &document,
+      std::string *sourcepos = nullptr,
+      std::string_view *key = nullptr
+  ) const;
+  // The front matter type's converter, else the routed one.  key is set to its key.
+  Converter *selectConverter(
+      const Document &document,
+      const ConverterPreprocessor &pre,
+      std::string_view *key = nullptr
+  ) const;
+  std::string
+  renderBody(Converter &converter, const ConverterPreprocessor &pre, std::string *sourcepos)
+      const;
+  // last_render_ if the document is unchanged since, otherwise null
+  std::shared_ptr<const std::string> cachedRender(const Document &document) const;
+  std::string_view routeConverterKey(const Document &document, const TextSegments &body) const;
+  std::string largeFileNotice(const Document &document) const;
+  // Memoized in the document's render context
+  const std::string &calculateBaseUri(const Document &document) const;
+  std::string computeBaseUri(const Document &document) const;
+  const std::string &themeMode() const;
   PreviewPane &update(const Document &document);
+  bool unchangedSinceRender(const Document &document) const;
+  void switchView(const std::string &file);
   void addWatchIfNeeded(const std::filesystem::path &path);
   void stopAllWatches();
 
@@ -70,19 +129,76 @@ class PreviewPane final {
 
   ConverterRegistrar registrar_;
 
+  // Reused across updates; caches the parsed header block
+  mutable ConverterPreprocessor preprocessor_;
+
   bool update_pending_ = false;
   gint64 last_update_time_ = 0;
 
+  // What the webview currently shows; edits that leave the text unchanged
+  // (styling, markers, undo back to it) don't need a render
+  std::string rendered_file_;
+  std::optional<size_t> rendered_digest_;
+  std::uint64_t rendered_generation_ = 0;  // checked before the digest
+
+  // Last converted HTML, reused by HTML export while the text is unchanged
+  struct LastRender {
+    std::string file;
+    size_t digest = 0;
+    std::uint64_t text_generation = 0;
+    std::uint64_t config_generation = 0;
+    std::shared_ptr<const std::string> html;
+    std::string_view key;  // converter that produced html
+  };
+  LastRender last_render_;
+
+  struct PdfExport {
+    std::filesystem::path dest;
+    std::function<void(bool)> callback;
+    std::atomic<bool> cancelled{ false };
+    guint print_id = 0;     // once the page is rendered
+    bool writing = false;   // a worker writes dest; ends when it returns
+    guint pulse_source = 0;
+  };
+  static constexpr guint kPulseInterval = 100;  // ms
+  void printPdf(
+      std::shared_ptr<PdfExport> job,
+      const std::string &page,
+      const std::string &base_uri
+  );
+  void finishPdfExport(const std::shared_ptr<PdfExport> &job, bool ok);
+  std::shared_ptr<PdfExport> pdf_export_;
+  ProgressDialog pdf_progress_;
+
   std::unordered_map<std::string, double> scroll_by_file_;
+  std::unordered_set<std::string> force_render_files_;
   std::string previous_key_ = "markdown";
   std::string previous_theme_ = "system";
 
+  // theme_mode setting, reread when the config changes
+  mutable std::string theme_mode_;
+  mutable std::uint64_t theme_generation_ = 0;
+
   std::unordered_map<std::filesystem::path, FileUtils::FileWatchHandle> watches_;
   std::string previous_base_uri_;
 
   bool webview_healthy_ = false;
   std::string root_id_;
 
+  // Render state of pooled views that are not current, by document path
+  struct ViewState {
+    std::string root_id;
+    std::string base_uri;
+    std::string key;
+    std::string theme;
+    bool healthy = false;
+    std::string rendered_file;
+    std::optional<size_t> rendered_digest;
+  };
+  std::string view_file_;  // document bound to the current view
+  std::uint64_t navigation_ = 0;
+  std::unordered_map<std::string, ViewState> parked_views_;
+
   // workaround for resize artifact
   void connectPanedHandlers();
   void onPanedButtonPress(GdkEventButton *event);
@@ -18,6 +18,7 @@
 #include <plugindata.h>
 #include <ui_utils.h>
 
+#include "batch_export.h"
 #include "preview_pane.h"
 #include "subprocess.h"
 #include "util/gtk_utils.h"
@@ -244,7 +245,7 @@ void PreviewShortcuts::onFocusPreviewEditor(guint /*key_id*/) {
 
   if (!inEditor && !inPreview) {
     auto &cfg = PreviewConfig::instance();
-    bool strict = cfg.get<bool>("keybinding_behavior_strict", false);
+    bool strict = cfg.get(Settings::kKeybindingBehaviorStrict);
     if (strict) {
       return;
     } else {
@@ -276,7 +277,7 @@ void PreviewShortcuts::onFocusSidebarEditor(guint /*key_id*/) {
 
   if (!inEditor && !inSidebar) {
     auto &cfg = PreviewConfig::instance();
-    bool strict = cfg.get<bool>("keybinding_behavior_strict", false);
+    bool strict = cfg.get(Settings::kKeybindingBehaviorStrict);
     if (strict) {
       return;
     } else {
@@ -302,7 +303,7 @@ void PreviewShortcuts::onOpenTerminal(guint /*key_id*/) {
   auto dirPath = std::filesystem::path(doc->real_path).parent_path();
 
   auto &cfg = PreviewConfig::instance();
-  std::string cmd = cfg.get<std::string>("terminal_command");
+  std::string cmd = cfg.get(Settings::kTerminalCommand);
 
   if (!Subprocess::commandExists(cmd)) {
     if (Subprocess::commandExists("xdg-terminal-exec")) {
@@ -339,7 +340,7 @@ void PreviewShortcuts::onOpenFileManager(guint /*key_id*/) {
   auto dirPath = std::filesystem::path(doc->real_path).parent_path();
 
   auto &cfg = PreviewConfig::instance();
-  std::string cmd = cfg.get<std::string>("file_manager_command");
+  std::string cmd = cfg.get(Settings::kFileManagerCommand);
 
   if (!Subprocess::commandExists(cmd)) {
     if (Subprocess::commandExists("xdg-open")) {
@@ -367,6 +368,11 @@ void PreviewShortcuts::onOpenFileManager(guint /*key_id*/) {
   }
 }
 
+void PreviewShortcuts::onBatchExport(guint /*key_id*/) {
+  auto &ctx = PreviewContext::instance();
+  BatchExport::instance().showDialog(GTK_WINDOW(ctx.geany_data_->main_widgets->window));
+}
+
 void PreviewShortcuts::onPreferences(guint /*key_id*/) {
   auto &ctx = PreviewContext::instance();
   ctx.openPreferences();
@@ -418,7 +424,7 @@ void PreviewShortcuts::onZoomInBoth(guint /*key_id*/) {
   }
 
   auto &cfg = PreviewConfig::instance();
-  bool sync = cfg.get<bool>("preview_zoom_sync", false);
+  bool sync = cfg.get(Settings::kPreviewZoomSync);
 
   if (sync) {
     scintilla_send_message(sci, SCI_ZOOMIN, 0, 0);
@@ -439,7 +445,7 @@ void PreviewShortcuts::onZoomOutBoth(guint /*key_id*/) {
   }
 
   auto &cfg = PreviewConfig::instance();
-  bool sync = cfg.get<bool>("preview_zoom_sync", false);
+  bool sync = cfg.get(Settings::kPreviewZoomSync);
 
   auto &wv = WebView::instance();
   if (sync) {
@@ -461,7 +467,7 @@ void PreviewShortcuts::onResetZoomBoth(guint /*key_id*/) {
   }
 
   auto &cfg = PreviewConfig::instance();
-  bool sync = cfg.get<bool>("preview_zoom_sync", false);
+  bool sync = cfg.get(Settings::kPreviewZoomSync);
 
   auto &wv = WebView::instance();
   if (sync) {
@@ -83,6 +83,8 @@ class PreviewShortcuts {
   static void onOpenTerminal(guint /*key_id*/);
   static void onOpenFileManager(guint /*key_id*/);
 
+  static void onBatchExport(guint /*key_id*/);
+
   static void onPreferences(guint /*key_id*/);
 
   static void onToggleSidebar(guint /*key_id*/);
@@ -179,6 +181,10 @@ class PreviewShortcuts {
       "Open File Manager at file location",
       onOpenFileManager },
 
+    { "Batch Export",
+      "Export open documents or a folder of documents to HTML or PDF",
+      onBatchExport },
+
     { "Preferences",
       "Preferences",
       onPreferences },
@@ -0,0 +1,132 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "progress_dialog.h"
+
+#include <string>
+
+#include "preview_context.h"
+
+ProgressDialog::~ProgressDialog() {
+  close();
+}
+
+void ProgressDialog::start(const char *title, std::function<void()> on_cancel) {
+  on_cancel_ = std::move(on_cancel);
+  if (!dialog_) {
+    create(title);
+  } else {
+    gtk_window_set_title(GTK_WINDOW(dialog_), title);
+  }
+
+  GtkWidget *button =
+      gtk_dialog_get_widget_for_response(GTK_DIALOG(dialog_), GTK_RESPONSE_CANCEL);
+  gtk_button_set_label(GTK_BUTTON(button), "_Cancel");
+  gtk_label_set_text(GTK_LABEL(label_), "");
+  gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(bar_), 0.0);
+  gtk_progress_bar_set_text(GTK_PROGRESS_BAR(bar_), nullptr);
+  gtk_window_present(GTK_WINDOW(dialog_));
+}
+
+void ProgressDialog::present() {
+  if (dialog_) {
+    gtk_window_present(GTK_WINDOW(dialog_));
+  }
+}
+
+void ProgressDialog::close() {
+  on_cancel_ = nullptr;
+  if (dialog_) {
+    gtk_widget_destroy(dialog_);  // clears the pointers
+  }
+}
+
+void ProgressDialog::setStatus(std::string_view text) {
+  if (label_) {
+    gtk_label_set_text(GTK_LABEL(label_), std::string{ text }.c_str());
+  }
+}
+
+void ProgressDialog::setProgress(double fraction, std::string_view text) {
+  if (!bar_) {
+    return;
+  }
+
+  if (fraction < 0.0) {
+    gtk_progress_bar_pulse(GTK_PROGRESS_BAR(bar_));
+  } else {
+    gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(bar_), fraction);
+  }
+  gtk_progress_bar_set_text(
+      GTK_PROGRESS_BAR(bar_), text.empty() ? nullptr : std::string{ text }.c_str()
+  );
+}
+
+void ProgressDialog::finish(std::string_view summary, bool complete) {
+  on_cancel_ = nullptr;
+  if (!dialog_) {
+    return;
+  }
+
+  setStatus(summary);
+  if (complete) {
+    gtk_progress_bar_set_fraction(GTK_PROGRESS_BAR(bar_), 1.0);
+  }
+  GtkWidget *button =
+      gtk_dialog_get_widget_for_response(GTK_DIALOG(dialog_), GTK_RESPONSE_CANCEL);
+  gtk_button_set_label(GTK_BUTTON(button), "_Close");
+}
+
+void ProgressDialog::create(const char *title) {
+  auto &ctx = PreviewContext::instance();
+  GtkWindow *parent =
+      ctx.geany_data_ ? GTK_WINDOW(ctx.geany_data_->main_widgets->window) : nullptr;
+
+  // Not modal: the editor stays usable while the task runs
+  dialog_ = gtk_dialog_new_with_buttons(
+      title, parent, GTK_DIALOG_DESTROY_WITH_PARENT, "_Cancel", GTK_RESPONSE_CANCEL, nullptr
+  );
+  gtk_window_set_default_size(GTK_WINDOW(dialog_), 420, -1);
+
+  GtkWidget *content = gtk_dialog_get_content_area(GTK_DIALOG(dialog_));
+  gtk_container_set_border_width(GTK_CONTAINER(content), 12);
+  gtk_box_set_spacing(GTK_BOX(content), 6);
+
+  label_ = gtk_label_new(nullptr);
+  gtk_label_set_xalign(GTK_LABEL(label_), 0.0f);
+  gtk_label_set_ellipsize(GTK_LABEL(label_), PANGO_ELLIPSIZE_MIDDLE);
+  gtk_box_pack_start(GTK_BOX(content), label_, false, false, 0);
+
+  bar_ = gtk_progress_bar_new();
+  gtk_progress_bar_set_show_text(GTK_PROGRESS_BAR(bar_), true);
+  gtk_box_pack_start(GTK_BOX(content), bar_, false, false, 0);
+
+  g_signal_connect(
+      dialog_,
+      "response",
+      G_CALLBACK(+[](GtkDialog *dialog, gint, gpointer user_data) {
+        auto *self = static_cast<ProgressDialog *>(user_data);
+        if (self->on_cancel_) {
+          // The task ends through finish() or close()
+          auto on_cancel = self->on_cancel_;
+          on_cancel();
+        } else {
+          gtk_widget_destroy(GTK_WIDGET(dialog));
+        }
+      }),
+      this
+  );
+  g_signal_connect(
+      dialog_,
+      "destroy",
+      G_CALLBACK(+[](GtkWidget *, gpointer user_data) {
+        auto *self = static_cast<ProgressDialog *>(user_data);
+        self->dialog_ = nullptr;
+        self->label_ = nullptr;
+        self->bar_ = nullptr;
+      }),
+      this
+  );
+
+  gtk_widget_show_all(dialog_);
+}
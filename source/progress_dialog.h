@@ -0,0 +1,44 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <functional>
+#include <string_view>
+
+#include <gtk/gtk.h>
+
+// Non-modal window for a task running in the background: a status line, a
+// progress bar and a Cancel button that becomes Close once the task ends.
+// Main thread only.  The window is created on demand and may be closed at any
+// time; updates are ignored while it is gone.
+class ProgressDialog final {
+ public:
+  ProgressDialog() = default;
+  ~ProgressDialog();
+
+  ProgressDialog(const ProgressDialog &) = delete;
+  ProgressDialog &operator=(const ProgressDialog &) = delete;
+  ProgressDialog(ProgressDialog &&) = delete;
+  ProgressDialog &operator=(ProgressDialog &&) = delete;
+
+  // Shows the window for a new task; Cancel calls on_cancel until finish().
+  void start(const char *title, std::function<void()> on_cancel);
+  void present();
+  void close();
+
+  void setStatus(std::string_view text);
+  // Pulses when fraction is negative
+  void setProgress(double fraction, std::string_view text = {});
+
+  // Shows the summary and leaves the window open for the user to close.
+  void finish(std::string_view summary, bool complete);
+
+ private:
+  void create(const char *title);
+
+  GtkWidget *dialog_ = nullptr;
+  GtkWidget *label_ = nullptr;
+  GtkWidget *bar_ = nullptr;
+  std::function<void()> on_cancel_;
+};
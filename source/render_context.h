@@ -0,0 +1,23 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+// Values the render path needs on every update that only change when the
+// document is saved, renamed, reloaded, retyped or the config changes.
+// Geany documents share one per editor document; see DocumentGeany.
+struct RenderContext {
+  std::string file_path;
+  std::string filetype_name;
+  std::string encoding_name;
+
+  // Filled in on first use
+  std::optional<std::string_view> converter_key;  // static storage
+  std::string base_uri;
+  std::uint64_t base_uri_generation = 0;  // PreviewConfig::generation()
+};
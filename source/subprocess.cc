@@ -4,12 +4,15 @@
 #include "subprocess.h"
 
 #include <errno.h>
+#include <signal.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <sstream>
 #include <stdexcept>
@@ -19,6 +22,8 @@
 #include <msgwindow.h>
 #include <sys/types.h>  // for pid_t
 
+#include "tool_probe.h"
+
 std::unordered_map<std::string, Subprocess::CacheEntry> Subprocess::binary_cache_;
 
 namespace {
@@ -34,12 +39,37 @@ struct AsyncContext {
   Subprocess::CompletionHandler handler;
   int exit_status{ -1 };
   int streams_remaining{ kNumStreams };  // stdout + stderr still open
-  guint out_watch_id{ 0 };
-  guint err_watch_id{ 0 };
-  guint child_watch_id{ 0 };
-  bool cancelled{ false };
+  GSource *out_watch{ nullptr };
+  GSource *err_watch{ nullptr };
+  GSource *child_watch{ nullptr };
+  GMainContext *context{ nullptr };  // where the sources are attached
+  std::atomic<bool> cancelled{ false };
 };
 static std::set<AsyncContext *> active_contexts;
+static bool shut_down = false;
+
+// Guards active_contexts, shut_down and Subprocess::binary_cache_; converters
+// may run on worker threads.
+std::mutex &subprocessMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+void releaseSource(GSource *&source) {
+  if (source) {
+    g_source_destroy(source);
+    g_source_unref(source);
+    source = nullptr;
+  }
+}
+
+// Attaches to the calling thread's default main context, so worker threads that
+// run their own loop receive the callbacks instead of the UI thread.
+GSource *attachSource(GSource *source, GSourceFunc func, gpointer user_data) {
+  g_source_set_callback(source, func, user_data, nullptr);
+  g_source_attach(source, g_main_context_get_thread_default());
+  return source;
+}
 
 bool writeAll(int fd, std::string_view data) noexcept {
   std::size_t offset = 0;
@@ -64,29 +94,75 @@ bool writeAll(int fd, std::string_view data) noexcept {
   return true;
 }
 
+// Claims ctx for finishing; false if it was finished already.
+bool deactivate(AsyncContext *ctx) {
+  std::lock_guard<std::mutex> lock(subprocessMutex());
+  return active_contexts.erase(ctx) > 0;
+}
+
+// On the thread that owns ctx->context; ctx is deactivated.
+void finishProcess(AsyncContext *ctx, Subprocess::Result res) {
+  releaseSource(ctx->out_watch);
+  releaseSource(ctx->err_watch);
+  releaseSource(ctx->child_watch);
+  if (ctx->out_ch) {
+    g_io_channel_unref(ctx->out_ch);
+  }
+  if (ctx->err_ch) {
+    g_io_channel_unref(ctx->err_ch);
+  }
+  g_main_context_unref(ctx->context);
+
+  res.cancelled = ctx->cancelled;
+  if (ctx->handler) {
+    ctx->handler(res);
+  }
+  delete ctx;
+}
+
 static void cleanupProcess(AsyncContext *ctx) {
-  if (ctx->streams_remaining == 0 && ctx->exit_status != -1) {
-    Subprocess::Result res{ ctx->outbuf.str(), ctx->errbuf.str(), ctx->exit_status };
-    if (ctx->handler) {
-      ctx->handler(res);
-    }
-    if (ctx->out_ch) {
-      g_io_channel_unref(ctx->out_ch);
-    }
-    if (ctx->err_ch) {
-      g_io_channel_unref(ctx->err_ch);
-    }
-    active_contexts.erase(ctx);
-    delete ctx;
+  if (ctx->streams_remaining == 0 && ctx->exit_status != -1 && deactivate(ctx)) {
+    finishProcess(ctx, { ctx->outbuf.str(), ctx->errbuf.str(), ctx->exit_status });
   }
 }
 
-gboolean readChannel(GIOChannel *source, GIOCondition condition, gpointer user_data) noexcept {
+// Invoked in ctx->context by cancelAll().  Completes the job like any other,
+// so a loop waiting for it quits.
+gboolean cancelProcess(gpointer user_data) noexcept {
   auto *ctx = static_cast<AsyncContext *>(user_data);
-  if (ctx->cancelled) {
-    return false;  // stop if cancelled
+  if (!deactivate(ctx)) {
+    return G_SOURCE_REMOVE;  // finished meanwhile; ctx is gone
   }
 
+  // Not reaped yet: kill it and reap it here, as the child watch goes away
+  releaseSource(ctx->child_watch);
+  if (ctx->exit_status == -1) {
+    ::kill(ctx->pid, SIGKILL);
+    while (::waitpid(ctx->pid, nullptr, 0) < 0 && errno == EINTR) {
+    }
+    g_spawn_close_pid(ctx->pid);
+  }
+
+  Subprocess::Result res;
+  res.stderr_data = "cancelled";
+  res.exit_status = 128 + SIGKILL;
+  finishProcess(ctx, std::move(res));
+  return G_SOURCE_REMOVE;
+}
+
+// Cancels ctx from its own loop, on any thread.  Callers hold the mutex, so
+// ctx is still active.
+void scheduleCancel(AsyncContext *ctx) {
+  ctx->cancelled = true;
+  GSource *source = g_idle_source_new();
+  g_source_set_priority(source, G_PRIORITY_HIGH);
+  g_source_set_callback(source, cancelProcess, ctx, nullptr);
+  g_source_attach(source, ctx->context);
+  g_source_unref(source);
+}
+
+gboolean readChannel(GIOChannel *source, GIOCondition condition, gpointer user_data) noexcept {
+  auto *ctx = static_cast<AsyncContext *>(user_data);
   if (condition & (G_IO_HUP | G_IO_ERR)) {
     --ctx->streams_remaining;
     cleanupProcess(ctx);
@@ -117,12 +193,6 @@ gboolean readChannel(GIOChannel *source, GIOCondition condition, gpointer user_d
 
 void onChildExit(GPid pid, gint status, gpointer user_data) noexcept {
   auto *ctx = static_cast<AsyncContext *>(user_data);
-  if (ctx->cancelled) {
-    g_spawn_close_pid(pid);
-    active_contexts.erase(ctx);
-    delete ctx;
-    return;
-  }
   int code = -1;
   if (WIFEXITED(status)) {
     code = WEXITSTATUS(status);
@@ -216,35 +286,54 @@ pid_t Subprocess::runWithPipes(
   }
 
   auto now = std::chrono::steady_clock::now();
-  auto it = binary_cache_.find(args[0]);
-  if (it != binary_cache_.end()) {
-    CacheEntry &entry = it->second;
-    if (!entry.found) {
-      // If still in cooldown, skip.
-      if (entry.last_check.time_since_epoch().count() != 0 &&
-          (now - entry.last_check) < entry.cooldown) {
-        return false;
+  {
+    std::lock_guard<std::mutex> lock(subprocessMutex());
+    if (shut_down) {
+      Subprocess::Result res;
+      res.stderr_data = "cancelled";
+      res.cancelled = true;
+      if (handler) {
+        handler(res);
       }
-      // Due for availability check.
-      entry.last_check = now;
-      if (commandExists(args[0])) {
-        // Reset on success.
-        entry.found = true;
-        entry.cooldown = kStartCooldown;
-      } else {
-        // Increase cooldown (cap and hold).
-        entry.cooldown = nextCooldown(entry.cooldown);
-        return false;
+      return 0;
+    }
+
+    auto it = binary_cache_.find(args[0]);
+    if (it != binary_cache_.end()) {
+      CacheEntry &entry = it->second;
+      if (!entry.found) {
+        // If still in cooldown, skip.
+        if (entry.last_check.time_since_epoch().count() != 0 &&
+            (now - entry.last_check) < entry.cooldown) {
+          return false;
+        }
+        // Due for availability check.
+        entry.last_check = now;
+        if (commandExists(args[0])) {
+          // Reset on success.
+          entry.found = true;
+          entry.cooldown = kStartCooldown;
+        } else {
+          // Increase cooldown (cap and hold).
+          entry.cooldown = nextCooldown(entry.cooldown);
+          return false;
+        }
       }
     }
   }
 
+  // Prefer the location found by the startup probe over a PATH search
+  auto tool = ToolProbe::instance().lookup(args[0]);
+
   // Build argv for GLib
   std::vector<gchar *> argv;
   argv.reserve(args.size() + 1);
   for (auto &a : args) {
     argv.push_back(const_cast<gchar *>(a.c_str()));
   }
+  if (tool) {
+    argv[0] = const_cast<gchar *>(tool->path.c_str());
+  }
   argv.push_back(nullptr);
 
   GPid pid = 0;
@@ -269,13 +358,17 @@ pid_t Subprocess::runWithPipes(
       g_error_free(error);
     }
     // Mark as missing and apply backoff if spawn fails.
-    auto &entry = binary_cache_[args[0]];
-    if (entry.last_check.time_since_epoch().count() == 0) {
-      entry.cooldown = kStartCooldown;
+    ToolProbe::instance().forget(args[0]);
+    {
+      std::lock_guard<std::mutex> lock(subprocessMutex());
+      auto &entry = binary_cache_[args[0]];
+      if (entry.last_check.time_since_epoch().count() == 0) {
+        entry.cooldown = kStartCooldown;
+      }
+      entry.found = false;
+      entry.last_check = now;
+      entry.cooldown = nextCooldown(entry.cooldown);
     }
-    entry.found = false;
-    entry.last_check = now;
-    entry.cooldown = nextCooldown(entry.cooldown);
     Subprocess::Result res;
     res.stderr_data = "spawn failed: " + msg;
     res.exit_status = 127;
@@ -309,45 +402,43 @@ pid_t Subprocess::runWithPipes(
   g_io_channel_set_close_on_unref(ctx->out_ch, true);
   g_io_channel_set_close_on_unref(ctx->err_ch, true);
 
-  ctx->out_watch_id = g_io_add_watch(
-      ctx->out_ch, GIOCondition(G_IO_IN | G_IO_HUP | G_IO_ERR), readChannel, ctx
+  ctx->context = g_main_context_ref_thread_default();
+
+  std::lock_guard<std::mutex> lock(subprocessMutex());
+  active_contexts.insert(ctx);
+  ctx->out_watch = attachSource(
+      g_io_create_watch(ctx->out_ch, GIOCondition(G_IO_IN | G_IO_HUP | G_IO_ERR)),
+      G_SOURCE_FUNC(readChannel),
+      ctx
   );
-  ctx->err_watch_id = g_io_add_watch(
-      ctx->err_ch, GIOCondition(G_IO_IN | G_IO_HUP | G_IO_ERR), readChannel, ctx
+  ctx->err_watch = attachSource(
+      g_io_create_watch(ctx->err_ch, GIOCondition(G_IO_IN | G_IO_HUP | G_IO_ERR)),
+      G_SOURCE_FUNC(readChannel),
+      ctx
   );
-  ctx->child_watch_id = g_child_watch_add(pid, onChildExit, ctx);
+  ctx->child_watch = attachSource(g_child_watch_source_new(pid), G_SOURCE_FUNC(onChildExit), ctx);
+  if (shut_down) {
+    scheduleCancel(ctx);  // shut down while spawning
+  }
 
-  active_contexts.insert(ctx);
   return pid;
 }
 
-// Cancel all active jobs, e.g. from plugin cleanup
+// Each job completes with a cancelled result on its own thread, so a loop
+// waiting for it quits.
 void Subprocess::cancelAll() noexcept {
+  std::lock_guard<std::mutex> lock(subprocessMutex());
   for (auto *ctx : active_contexts) {
-    ctx->cancelled = true;
-    if (ctx->out_watch_id) {
-      g_source_remove(ctx->out_watch_id);
-      ctx->out_watch_id = 0;
-    }
-    if (ctx->err_watch_id) {
-      g_source_remove(ctx->err_watch_id);
-      ctx->err_watch_id = 0;
-    }
-    if (ctx->child_watch_id) {
-      g_source_remove(ctx->child_watch_id);
-      ctx->child_watch_id = 0;
+    if (!ctx->cancelled) {
+      scheduleCancel(ctx);
     }
-    if (ctx->out_ch) {
-      g_io_channel_unref(ctx->out_ch);
-    }
-    if (ctx->err_ch) {
-      g_io_channel_unref(ctx->err_ch);
-    }
-    // child pid will be closed in onChildExit or here:
-    if (ctx->pid) {
-      g_spawn_close_pid(ctx->pid);
-    }
-    delete ctx;
   }
-  active_contexts.clear();
+}
+
+void Subprocess::shutdown() noexcept {
+  {
+    std::lock_guard<std::mutex> lock(subprocessMutex());
+    shut_down = true;
+  }
+  cancelAll();
 }
@@ -18,6 +18,7 @@ class Subprocess {
     std::string stdout_data;
     std::string stderr_data;
     int exit_status = -1;
+    bool cancelled = false;  // by cancelAll(); the output is incomplete
   };
 
   using CompletionHandler = std::function<void(const Result &)>;
@@ -39,7 +40,11 @@ class Subprocess {
 
   static pid_t runAsync(const std::string &command) noexcept;
 
+  // Kills the running processes.  Each handler is still called, on the thread
+  // that started the process, with a cancelled result.
   static void cancelAll() noexcept;
+  // cancelAll(), and later processes are refused as cancelled.  For cleanup.
+  static void shutdown() noexcept;
 
  private:
   static std::chrono::seconds nextCooldown(std::chrono::seconds current) noexcept;
@@ -0,0 +1,133 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+// Text stored in at most two pieces, e.g. the halves of Scintilla's gap
+// buffer.  Reading the pieces separately leaves the gap where it is.
+class TextSegments {
+ public:
+  TextSegments() = default;
+  TextSegments(std::string_view text) : parts_{ text, {} }, count_(text.empty() ? 0 : 1) {}
+  TextSegments(std::string_view first, std::string_view second) {
+    for (auto part : { first, second }) {
+      if (!part.empty()) {
+        parts_[count_++] = part;
+      }
+    }
+  }
+
+  std::size_t size() const noexcept {
+    return parts_[0].size() + parts_[1].size();
+  }
+  bool empty() const noexcept {
+    return count_ == 0;
+  }
+  bool isContiguous() const noexcept {
+    return count_ <= 1;
+  }
+
+  // Non-empty pieces in order.
+  std::size_t count() const noexcept {
+    return count_;
+  }
+  std::string_view part(std::size_t i) const noexcept {
+    return parts_[i];
+  }
+  std::string_view front() const noexcept {
+    return parts_[0];
+  }
+
+  char operator[](std::size_t pos) const noexcept {
+    return pos < parts_[0].size() ? parts_[0][pos] : parts_[1][pos - parts_[0].size()];
+  }
+
+  TextSegments substr(std::size_t pos, std::size_t len = std::string_view::npos) const {
+    pos = std::min(pos, size());
+    len = std::min(len, size() - pos);
+    const std::size_t split = parts_[0].size();
+    if (pos + len <= split) {
+      return parts_[0].substr(pos, len);
+    }
+    if (pos >= split) {
+      return parts_[1].substr(pos - split, len);
+    }
+    return { parts_[0].substr(pos), parts_[1].substr(0, pos + len - split) };
+  }
+
+  // Position of the first c in [from, to), or npos.
+  std::size_t find(char c, std::size_t from = 0, std::size_t to = std::string_view::npos) const {
+    to = std::min(to, size());
+    std::size_t base = 0;
+    for (std::size_t i = 0; i < count_ && from < to; ++i) {
+      const std::string_view p = parts_[i];
+      if (from < base + p.size()) {
+        const std::size_t end = std::min(to, base + p.size());
+        if (const void *hit = std::memchr(p.data() + (from - base), c, end - from)) {
+          return base + static_cast<std::size_t>(static_cast<const char *>(hit) - p.data());
+        }
+        from = end;
+      }
+      base += p.size();
+    }
+    return std::string_view::npos;
+  }
+
+  // True if the text at pos equals bytes.
+  bool matches(std::size_t pos, std::string_view bytes) const noexcept {
+    if (pos > size() || bytes.size() > size() - pos) {
+      return false;
+    }
+    bool equal = true;
+    forEach(pos, bytes.size(), [&](std::string_view piece, std::size_t offset) {
+      equal = equal && std::memcmp(piece.data(), bytes.data() + offset, piece.size()) == 0;
+    });
+    return equal;
+  }
+
+  void appendTo(std::string &out, std::size_t pos = 0, std::size_t len = std::string_view::npos)
+      const {
+    forEach(pos, len, [&](std::string_view piece, std::size_t) { out.append(piece); });
+  }
+
+  std::string str() const {
+    std::string out;
+    out.reserve(size());
+    appendTo(out);
+    return out;
+  }
+
+  // First n bytes as one view: into the text if they are contiguous there,
+  // otherwise copied into scratch.
+  std::string_view prefix(std::size_t n, std::string &scratch) const {
+    n = std::min(n, size());
+    if (n <= parts_[0].size()) {
+      return parts_[0].substr(0, n);
+    }
+    scratch.clear();
+    appendTo(scratch, 0, n);
+    return scratch;
+  }
+
+ private:
+  // Calls fn(piece, offset_in_range) for the pieces covering [pos, pos + len).
+  template <typename Fn>
+  void forEach(std::size_t pos, std::size_t len, Fn &&fn) const {
+    TextSegments range = substr(pos, len);
+    std::size_t offset = 0;
+    for (std::size_t i = 0; i < range.count_; ++i) {
+      fn(range.parts_[i], offset);
+      offset += range.parts_[i].size();
+    }
+  }
+
+  std::array<std::string_view, 2> parts_{};
+  std::size_t count_ = 0;
+};
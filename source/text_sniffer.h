@@ -0,0 +1,97 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cctype>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+
+// Guesses from a sample of the text whether it is Markdown or prose, as opposed
+// to logs, data dumps and other text that is better shown preformatted.
+class TextSniffer {
+ public:
+  // Only this much of the text is examined
+  static constexpr std::size_t kSampleSize = 64 * 1024;
+
+  struct Stats {
+    std::size_t lines = 0;
+    std::size_t blank_lines = 0;
+    std::size_t long_lines = 0;
+    std::size_t markdown_lines = 0;
+  };
+
+  static Stats analyze(std::string_view text, std::size_t sample_size = kSampleSize) {
+    Stats stats;
+    text = text.substr(0, sample_size);
+
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+      const void *nl = std::memchr(text.data() + pos, '\n', text.size() - pos);
+      std::size_t end = nl ? static_cast<const char *>(nl) - text.data() : text.size();
+      std::string_view line = text.substr(pos, end - pos);
+      pos = end + 1;
+
+      ++stats.lines;
+      if (line.find_first_not_of(" \t\r") == std::string_view::npos) {
+        ++stats.blank_lines;
+      } else if (line.size() > kLongLine) {
+        ++stats.long_lines;
+      }
+      if (hasMarkdownMarker(line)) {
+        ++stats.markdown_lines;
+      }
+    }
+    return stats;
+  }
+
+  static bool looksLikeMarkdown(std::string_view text) {
+    Stats s = analyze(text);
+    std::size_t content = s.lines - s.blank_lines;
+    if (content < kMinLines) {
+      return true;
+    }
+
+    // Any noticeable amount of Markdown syntax wins.
+    if (s.markdown_lines * 20 >= content) {
+      return true;
+    }
+
+    // Very long lines, or no paragraph breaks at all: logs, CSV, dumps.
+    if (s.long_lines * 10 > content) {
+      return false;
+    }
+    return s.blank_lines * 50 >= content;
+  }
+
+ private:
+  static constexpr std::size_t kLongLine = 300;
+  static constexpr std::size_t kMinLines = 20;
+
+  static bool hasMarkdownMarker(std::string_view line) {
+    std::size_t indent = line.find_first_not_of(' ');
+    if (indent == std::string_view::npos || indent > 3) {
+      return false;
+    }
+    line.remove_prefix(indent);
+
+    auto startsWith = [&](std::string_view p) { return line.substr(0, p.size()) == p; };
+    if (startsWith("# ") || startsWith("## ") || startsWith("### ") || startsWith("- ") ||
+        startsWith("* ") || startsWith("+ ") || startsWith("> ") || startsWith("```") ||
+        startsWith("~~~") || startsWith("|")) {
+      return true;
+    }
+
+    std::size_t digits = 0;
+    while (digits < line.size() && std::isdigit(static_cast<unsigned char>(line[digits]))) {
+      ++digits;
+    }
+    if (digits > 0 && digits < 10 && line.substr(digits, 2) == ". ") {
+      return true;
+    }
+
+    return line.find("](") != std::string_view::npos || line.find("**") != std::string_view::npos ||
+           line.find('`') != std::string_view::npos;
+  }
+};
@@ -0,0 +1,228 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "tool_probe.h"
+
+#include <cerrno>
+#include <csignal>
+#include <fstream>
+#include <utility>
+
+#include <glib.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <toml++/toml.h>
+
+#include "util/thread_pool.h"
+
+void ToolProbe::startAsync(std::filesystem::path cache_file, std::vector<std::string> binaries) {
+  ThreadPool::instance().post([this, cache_file = std::move(cache_file),
+                               binaries = std::move(binaries)] { probe(cache_file, binaries); });
+}
+
+std::optional<ToolProbe::Tool> ToolProbe::lookup(std::string_view binary) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = tools_.find(std::string(binary));
+  if (it == tools_.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
+
+void ToolProbe::forget(std::string_view binary) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  tools_.erase(std::string(binary));
+}
+
+void ToolProbe::probe(
+    const std::filesystem::path &cache_file,
+    const std::vector<std::string> &binaries
+) {
+  const char *env = g_getenv("PATH");
+  const std::string path_env = env ? env : "";
+
+  auto cached = loadCache(cache_file, path_env);
+
+  std::unordered_map<std::string, Tool> results;
+  for (const auto &binary : binaries) {
+    // Still the same file as last time: nothing to do
+    auto it = cached.find(binary);
+    if (it != cached.end() && !it->second.path.empty()) {
+      auto mtime = executableMtime(it->second.path);
+      if (mtime && *mtime == it->second.mtime) {
+        results.emplace(binary, it->second);
+        continue;
+      }
+    }
+
+    // New, changed or previously missing: search PATH and ask for the version
+    Tool tool;
+    if (gchar *resolved = g_find_program_in_path(binary.c_str())) {
+      tool.path = resolved;
+      g_free(resolved);
+      tool.mtime = executableMtime(tool.path).value_or(0);
+      tool.version = queryVersion(tool.path);
+    }
+    results.emplace(binary, std::move(tool));
+  }
+
+  // Misses are saved too (empty path), so an unchanged setup is not rewritten
+  bool changed = results.size() != cached.size();
+  for (const auto &[binary, tool] : results) {
+    auto it = cached.find(binary);
+    changed = changed || it == cached.end() || it->second.path != tool.path ||
+              it->second.mtime != tool.mtime;
+  }
+  if (changed) {
+    saveCache(cache_file, path_env, results);
+  }
+
+  std::erase_if(results, [](const auto &kv) { return kv.second.path.empty(); });
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  tools_ = std::move(results);
+}
+
+std::unordered_map<std::string, ToolProbe::Tool> ToolProbe::loadCache(
+    const std::filesystem::path &cache_file,
+    const std::string &path_env
+) {
+  std::unordered_map<std::string, Tool> tools;
+  std::error_code ec;
+  if (!std::filesystem::exists(cache_file, ec)) {
+    return tools;
+  }
+
+  try {
+    auto tbl = toml::parse_file(cache_file.string());
+
+    // A different PATH may resolve to different binaries
+    if (tbl["path_env"].value_or(std::string{}) != path_env) {
+      return tools;
+    }
+
+    if (auto tools_tbl = tbl["tools"].as_table()) {
+      for (auto &[name, node] : *tools_tbl) {
+        auto *entry = node.as_table();
+        if (!entry) {
+          continue;
+        }
+        Tool tool;
+        tool.path = (*entry)["path"].value_or(std::string{});
+        tool.version = (*entry)["version"].value_or(std::string{});
+        tool.mtime = (*entry)["mtime"].value_or(std::int64_t{ 0 });
+        tools.emplace(std::string(name.str()), std::move(tool));
+      }
+    }
+  } catch (const toml::parse_error &) {
+    tools.clear();  // rebuilt and rewritten by the probe
+  }
+  return tools;
+}
+
+void ToolProbe::saveCache(
+    const std::filesystem::path &cache_file,
+    const std::string &path_env,
+    const std::unordered_map<std::string, Tool> &tools
+) {
+  toml::table tools_tbl;
+  for (const auto &[name, tool] : tools) {
+    toml::table entry;
+    entry.insert_or_assign("path", tool.path);
+    entry.insert_or_assign("version", tool.version);
+    entry.insert_or_assign("mtime", tool.mtime);
+    tools_tbl.insert_or_assign(name, std::move(entry));
+  }
+
+  toml::table root;
+  root.insert_or_assign("path_env", path_env);
+  root.insert_or_assign("tools", std::move(tools_tbl));
+
+  std::error_code ec;
+  std::filesystem::create_directories(cache_file.parent_path(), ec);
+
+  // Write to a temporary file first so a crash never leaves a torn cache
+  auto tmp = cache_file;
+  tmp += ".tmp";
+  {
+    std::ofstream out(tmp, std::ios::trunc);
+    out << root;
+    if (!out) {
+      std::filesystem::remove(tmp, ec);
+      return;
+    }
+  }
+  std::filesystem::rename(tmp, cache_file, ec);
+}
+
+std::optional<std::int64_t> ToolProbe::executableMtime(const std::string &path) {
+  struct stat st {};
+  if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode) || access(path.c_str(), X_OK) != 0) {
+    return std::nullopt;
+  }
+  return static_cast<std::int64_t>(st.st_mtime);
+}
+
+std::string ToolProbe::queryVersion(const std::string &path) {
+  const gchar *argv[] = { path.c_str(), "--version", nullptr };
+  GPid pid = 0;
+  gint out_fd = -1;
+
+  if (!g_spawn_async_with_pipes(
+          nullptr,
+          const_cast<gchar **>(argv),
+          nullptr,
+          static_cast<GSpawnFlags>(G_SPAWN_DO_NOT_REAP_CHILD | G_SPAWN_STDERR_TO_DEV_NULL),
+          [](gpointer) { setpgid(0, 0); },  // so its children can be killed with it
+          nullptr,
+          &pid,
+          nullptr,
+          &out_fd,
+          nullptr,
+          nullptr
+      )) {
+    return {};
+  }
+
+  // Read until EOF, the first line or the deadline, on this worker thread
+  std::string version;
+  const gint64 deadline = g_get_monotonic_time() + kVersionTimeout * G_TIME_SPAN_MILLISECOND;
+  char buf[512];
+  while (version.find('\n') == std::string::npos) {
+    auto left = (deadline - g_get_monotonic_time()) / G_TIME_SPAN_MILLISECOND;
+    pollfd pfd{ out_fd, POLLIN, 0 };
+    int ready = left > 0 ? ::poll(&pfd, 1, static_cast<int>(left)) : 0;
+    if (ready < 0 && errno == EINTR) {
+      continue;
+    }
+    if (ready <= 0) {
+      version.clear();  // timed out
+      break;
+    }
+    auto n = ::read(out_fd, buf, sizeof(buf));
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      break;
+    }
+    version.append(buf, static_cast<std::size_t>(n));
+  }
+  ::close(out_fd);
+
+  // Done with it either way; a hanging one must not outlive the probe
+  ::kill(-pid, SIGKILL);
+  while (::waitpid(pid, nullptr, 0) < 0 && errno == EINTR) {
+  }
+  g_spawn_close_pid(pid);
+
+  // first line only
+  auto eol = version.find('\n');
+  if (eol != std::string::npos) {
+    version.resize(eol);
+  }
+  return version;
+}
@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Resolves external converter binaries off the UI thread and remembers the
+// results across sessions.  Cached entries are revalidated with stat(); only
+// new or changed binaries are searched for and asked for their version.  A
+// binary that doesn't answer within kVersionTimeout is killed.
+class ToolProbe {
+ public:
+  static ToolProbe &instance() {
+    static ToolProbe inst;
+    return inst;
+  }
+
+ private:
+  ToolProbe() = default;
+  ~ToolProbe() = default;
+
+  ToolProbe(const ToolProbe &) = delete;
+  ToolProbe &operator=(const ToolProbe &) = delete;
+  ToolProbe(ToolProbe &&) = delete;
+  ToolProbe &operator=(ToolProbe &&) = delete;
+
+ public:
+  struct Tool {
+    std::string path;  // absolute
+    std::string version;
+    std::int64_t mtime = 0;
+  };
+
+  // Loads the cache file and probes the binaries on the thread pool.
+  void startAsync(std::filesystem::path cache_file, std::vector<std::string> binaries);
+
+  // Known location of the binary, if probing found it.
+  std::optional<Tool> lookup(std::string_view binary) const;
+
+  // Drops the entry, e.g. after a spawn from the cached path failed.
+  void forget(std::string_view binary);
+
+ private:
+  void probe(const std::filesystem::path &cache_file, const std::vector<std::string> &binaries);
+
+  static std::unordered_map<std::string, Tool> loadCache(
+      const std::filesystem::path &cache_file,
+      const std::string &path_env
+  );
+  static void saveCache(
+      const std::filesystem::path &cache_file,
+      const std::string &path_env,
+      const std::unordered_map<std::string, Tool> &tools
+  );
+
+  static constexpr int kVersionTimeout = 2000;  // ms
+
+  static std::optional<std::int64_t> executableMtime(const std::string &path);
+  // First line of `path --version`; empty on failure or timeout
+  static std::string queryVersion(const std::string &path);
+
+  mutable std::mutex mutex_;
+  std::unordered_map<std::string, Tool> tools_;  // found binaries only
+};
@@ -32,7 +32,9 @@ class TweakUiAutoSetPwd : public TweakUi<TweakUiAutoSetPwd> {
     );
 
     auto &cfg = PreviewConfig::instance();
-    cfg.connectChanged([this]() { documentSignal(nullptr, nullptr, this); });
+    cfg.subscribe({ "tweakui/auto_set_pwd" }, [this](const auto &) {
+      documentSignal(nullptr, nullptr, this);
+    });
 
     // Hook into document activation (fires on open/new/switch)
     plugin_signal_connect(
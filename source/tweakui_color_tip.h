@@ -14,6 +14,7 @@
 #include <pluginutils.h>
 #include <scintilla/Scintilla.h>
 
+#include "editor_notify.h"
 #include "preview_config.h"
 #include "preview_context.h"
 #include "tweakui.h"
@@ -26,35 +27,35 @@ class TweakUiColorTip : public TweakUi<TweakUiColorTip> {
       return;
     }
 
-    // Connect button-press for already-open docs if chooser enabled
-    if (colorChooserEnabled() && main_is_realized()) {
-      auto *docs = ctx.geany_data_->documents_array;
-      for (guint i = 0; i < docs->len; ++i) {
-        auto *doc = static_cast<GeanyDocument *>(g_ptr_array_index(docs, i));
-        if (DOC_VALID(doc)) {
-          connectDocumentButtonPressSignalHandler(doc);
-        }
-      }
-    }
-
-    PreviewConfig::registerSetting(
+    tooltip_enabled_ = PreviewConfig::registerSetting(
         "tweakui/color_tooltip",
         false,
         "Show hex colors in tooltips when the mouse hovers over them."
     );
 
-    PreviewConfig::registerSetting(
+    tooltip_size_ = PreviewConfig::registerSetting(
         "tweakui/color_tooltip/size",
-        "small",
+        std::string{ "small" },
         "Tooltip size: small, medium, or large. The first letter is significant."
     );
 
-    PreviewConfig::registerSetting(
+    chooser_enabled_ = PreviewConfig::registerSetting(
         "tweakui/color_tooltip/chooser",
         false,
         "Open the color chooser when double-clicking a color value."
     );
 
+    // Connect button-press for already-open docs if chooser enabled
+    if (colorChooserEnabled() && main_is_realized()) {
+      auto *docs = ctx.geany_data_->documents_array;
+      for (guint i = 0; i < docs->len; ++i) {
+        auto *doc = static_cast<GeanyDocument *>(g_ptr_array_index(docs, i));
+        if (DOC_VALID(doc)) {
+          connectDocumentButtonPressSignalHandler(doc);
+        }
+      }
+    }
+
     // Hook into document/editor signals
     plugin_signal_connect(
         ctx.geany_plugin_, nullptr, "document-open", true, G_CALLBACK(documentSignal), this
@@ -65,20 +66,20 @@ class TweakUiColorTip : public TweakUi<TweakUiColorTip> {
     plugin_signal_connect(
         ctx.geany_plugin_, nullptr, "document-close", false, G_CALLBACK(documentClose), this
     );
-    plugin_signal_connect(
-        ctx.geany_plugin_, nullptr, "editor-notify", false, G_CALLBACK(editorNotify), this
+    EditorNotify::instance().subscribe(
+        { { SCN_DWELLSTART }, { SCN_DWELLEND } },
+        [this](GeanyEditor *editor, const SCNotification *nt) { editorNotify(editor, nt); },
+        [this] { return colorTooltipEnabled(); }
     );
   }
 
  private:
   bool colorTooltipEnabled() const {
-    auto &cfg = PreviewConfig::instance();
-    return cfg.get<bool>("tweakui/color_tooltip", false);
+    return PreviewConfig::instance().get(tooltip_enabled_);
   }
 
   bool colorChooserEnabled() const {
-    auto &cfg = PreviewConfig::instance();
-    return cfg.get<bool>("tweakui/color_tooltip/chooser", false);
+    return PreviewConfig::instance().get(chooser_enabled_);
   }
 
   static int containsColorValue(char *string, int position, int maxdist) {
@@ -205,14 +206,8 @@ class TweakUiColorTip : public TweakUi<TweakUiColorTip> {
     );
   }
 
-  static bool
-  editorNotify(GObject *, GeanyEditor *editor, SCNotification *nt, gpointer user_data) {
-    auto *self = static_cast<TweakUiColorTip *>(user_data);
+  void editorNotify(GeanyEditor *editor, const SCNotification *nt) {
     ScintillaObject *sci = editor->sci;
-    if (!self->colorTooltipEnabled()) {
-      return false;
-    }
-
     switch (nt->nmhdr.code) {
       case SCN_DWELLSTART: {
         if (nt->position < 0) {
@@ -231,7 +226,7 @@ class TweakUiColorTip : public TweakUi<TweakUiColorTip> {
           int color = containsColorValue(subtext, pos, 2);
           if (color != -1) {
             auto &cfg = PreviewConfig::instance();
-            auto size = cfg.get<std::string>("tweakui/color_tooltip/size", "small");
+            auto size = cfg.get(tooltip_size_);
             char c = size.empty() ? 's' : std::tolower(size[0]);
 
             const char *tpl = (c == 'l')   ? colortip_templates_[2]
@@ -248,7 +243,6 @@ class TweakUiColorTip : public TweakUi<TweakUiColorTip> {
         scintilla_send_message(sci, SCI_CALLTIPCANCEL, 0, 0);
         break;
     }
-    return false;
   }
 
   // Local helpers
@@ -269,6 +263,10 @@ class TweakUiColorTip : public TweakUi<TweakUiColorTip> {
     return out;
   }
 
+  Setting<bool> tooltip_enabled_;
+  Setting<std::string> tooltip_size_;
+  Setting<bool> chooser_enabled_;
+
   static constexpr const char *colortip_templates_[] = {
     "    ",                                           // s
     "        \n        ",                             // m
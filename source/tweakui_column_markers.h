@@ -50,7 +50,10 @@ class TweakUiColumnMarkers : public TweakUi<TweakUiColumnMarkers> {
     );
 
     auto &cfg = PreviewConfig::instance();
-    cfg.connectChanged([this]() { show(); });
+    cfg.subscribe(
+        { "tweakui/column_markers", "tweakui/column_markers/*" },
+        [this](const auto &) { show(); }
+    );
 
     plugin_signal_connect(
         ctx.geany_plugin_, nullptr, "document-activate", true, G_CALLBACK(documentSignal), this
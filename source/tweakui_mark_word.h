@@ -11,6 +11,7 @@
 #include <gtk/gtk.h>
 #include <pluginutils.h>  // plugin_signal_connect()
 
+#include "editor_notify.h"
 #include "preview_config.h"
 #include "preview_context.h"
 #include "tweakui.h"
@@ -31,17 +32,17 @@ class TweakUiMarkWord : public TweakUi<TweakUiMarkWord> {
       }
     }
 
-    PreviewConfig::registerSetting(
+    enabled_ = PreviewConfig::registerSetting(
         "tweakui/mark_word", false, "Mark all occurrences of a word when double-clicking it."
     );
 
-    PreviewConfig::registerSetting(
+    double_click_delay_ = PreviewConfig::registerSetting(
         "tweakui/mark_word/double_click_delay",
         50,
         "Delay in milliseconds before marking all occurrences after a double-click."
     );
 
-    PreviewConfig::registerSetting(
+    single_click_deselect_ = PreviewConfig::registerSetting(
         "tweakui/mark_word/single_click_deselect",
         true,
         "Deselect the previous highlight by single click."
@@ -60,20 +61,21 @@ class TweakUiMarkWord : public TweakUi<TweakUiMarkWord> {
         ctx.geany_plugin_, nullptr, "document-close", false, G_CALLBACK(documentClose), this
     );
 
-    plugin_signal_connect(
-        ctx.geany_plugin_, nullptr, "editor-notify", false, G_CALLBACK(editorNotify), this
+    // Clears the highlight when a selection is deleted or dropped
+    EditorNotify::instance().subscribe(
+        { { SCN_MODIFIED, SC_MOD_BEFOREDELETE }, { SCN_UPDATEUI, SC_UPDATE_SELECTION } },
+        editorNotify,
+        [this] { return isEnabled() && singleClickDeselect(); }
     );
   }
 
  private:
   bool isEnabled() const {
-    auto &cfg = PreviewConfig::instance();
-    return cfg.get<bool>("tweakui/mark_word", false);
+    return PreviewConfig::instance().get(enabled_);
   }
 
   bool singleClickDeselect() const {
-    auto &cfg = PreviewConfig::instance();
-    return cfg.get<bool>("tweakui/mark_word/single_click_deselect", true);
+    return PreviewConfig::instance().get(single_click_deselect_);
   }
 
   static void clearMarker(GeanyDocument *doc = nullptr) {
@@ -106,8 +108,7 @@ class TweakUiMarkWord : public TweakUi<TweakUiMarkWord> {
       } else if (event->type == GDK_2BUTTON_PRESS) {
         if (self->double_click_timer_id_ == 0) {
           auto &cfg = PreviewConfig::instance();
-          int val = cfg.get<int>("tweakui/mark_word/double_click_delay", 50);
-          self->double_click_delay_ms_ = val;
+          self->double_click_delay_ms_ = cfg.get(self->double_click_delay_);
 
           self->double_click_timer_id_ =
               g_timeout_add(self->double_click_delay_ms_, G_SOURCE_FUNC(markWord), self);
@@ -146,24 +147,21 @@ class TweakUiMarkWord : public TweakUi<TweakUiMarkWord> {
     );
   }
 
-  static bool
-  editorNotify(GObject *, GeanyEditor *editor, SCNotification *nt, gpointer user_data) {
-    auto *self = static_cast<TweakUiMarkWord *>(user_data);
-    if (nt->nmhdr.code == SCN_MODIFIED &&
-        ((nt->modificationType & SC_MOD_BEFOREDELETE) == SC_MOD_BEFOREDELETE) &&
-        sci_has_selection(editor->sci)) {
-      if (self->isEnabled() && self->singleClickDeselect()) {
-        clearMarker(editor->document);
-      }
-    } else if (nt->nmhdr.code == SCN_UPDATEUI && nt->updated == SC_UPDATE_SELECTION &&
-               !sci_has_selection(editor->sci)) {
-      if (self->isEnabled() && self->singleClickDeselect()) {
+  static void editorNotify(GeanyEditor *editor, const SCNotification *nt) {
+    bool has_selection = sci_has_selection(editor->sci);
+    if (nt->nmhdr.code == SCN_MODIFIED) {
+      if (has_selection) {
         clearMarker(editor->document);
       }
+    } else if (nt->updated == SC_UPDATE_SELECTION && !has_selection) {
+      clearMarker(editor->document);
     }
-    return false;
   }
 
+  Setting<bool> enabled_;
+  Setting<int> double_click_delay_;
+  Setting<bool> single_click_deselect_;
+
   gulong double_click_timer_id_ = 0;
   int double_click_delay_ms_ = 50;
 };
@@ -5,9 +5,9 @@
 
 #include <string_view>
 
-#include <Scintilla.h>    // for SCNotification
-#include <pluginutils.h>  // for plugin_signal_connect()
+#include <Scintilla.h>  // for SCNotification
 
+#include "editor_notify.h"
 #include "preview_config.h"
 #include "preview_context.h"
 #include "tweakui.h"
@@ -20,39 +20,33 @@ class TweakUiUnchangeDocument : public TweakUi<TweakUiUnchangeDocument> {
       return;
     }
 
-    PreviewConfig::registerSetting(
+    enabled_ = PreviewConfig::registerSetting(
         "tweakui/unchange_document", false, "Mark new, unsaved, empty documents as unchanged."
     );
 
-    plugin_signal_connect(
-        ctx.geany_plugin_, nullptr, "editor-notify", false, G_CALLBACK(editorNotify), this
+    // Geany marks the document changed after the edit is notified
+    EditorNotify::instance().subscribe(
+        { { SCN_MODIFIED, SC_MOD_INSERTTEXT | SC_MOD_DELETETEXT },
+          { SCN_UPDATEUI, SC_UPDATE_CONTENT } },
+        [this](GeanyEditor *editor, const SCNotification *) { unchange(editor->document); },
+        [this] { return PreviewConfig::instance().get(enabled_); }
     );
   }
 
  private:
-  static gboolean
-  editorNotify(GObject *, GeanyEditor *editor, SCNotification *, gpointer user_data) {
-    auto *self = static_cast<TweakUiUnchangeDocument *>(user_data);
-    self->unchange(editor->document);
-    return false;  // let Geany continue processing
-  }
-
   void unchange(GeanyDocument *doc) {
     if (!DOC_VALID(doc) || !doc->changed) {
       return;
     }
 
-    auto &cfg = PreviewConfig::instance();
-    if (!cfg.get<bool>("tweakui/unchange_document", false)) {
-      return;
-    }
-
     // Only unmark if it's an untitled, empty buffer
     if (std::string_view(DOC_FILENAME(doc)) == std::string_view(GEANY_STRING_UNTITLED) &&
         sci_get_length(doc->editor->sci) == 0) {
       document_set_text_changed(doc, false);
     }
   }
+
+  Setting<bool> enabled_;
 };
 
 template class TweakUi<TweakUiUnchangeDocument>;
@@ -4,6 +4,7 @@
 #pragma once
 
 #include <atomic>
+#include <cerrno>
 #include <filesystem>
 #include <fstream>
 #include <functional>
@@ -11,6 +12,12 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 namespace FileUtils {
 
@@ -105,6 +112,120 @@ inline std::string readFileToString(const std::filesystem::path &path) {
   return buffer.str();
 }
 
+// Read-only view of a file's contents.  Regular files are memory-mapped;
+// pipes, special files and failed mappings are read into a buffer instead.
+// A mapped file that is truncated by another process while mapped can raise
+// SIGBUS on access, as with any mmap reader; map = false always reads.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  explicit MappedFile(const std::filesystem::path &path, bool map = true) {
+    open(path, map);
+  }
+  ~MappedFile() {
+    close();
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  MappedFile(MappedFile &&other) noexcept {
+    *this = std::move(other);
+  }
+  MappedFile &operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+      close();
+      map_ = other.map_;
+      map_size_ = other.map_size_;
+      buffer_ = std::move(other.buffer_);
+      ok_ = other.ok_;
+      other.map_ = nullptr;
+      other.map_size_ = 0;
+      other.ok_ = false;
+    }
+    return *this;
+  }
+
+  bool open(const std::filesystem::path &path, bool map = true) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      return false;
+    }
+
+    struct stat st {};
+    bool regular = fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0;
+    if (regular && map) {
+      void *p = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        map_ = p;
+        map_size_ = static_cast<std::size_t>(st.st_size);
+        ok_ = true;
+        ::close(fd);
+        return true;
+      }
+    }
+
+    // Fallback: plain reads until EOF
+    if (regular) {
+      buffer_.reserve(static_cast<std::size_t>(st.st_size));
+    }
+    char chunk[64 * 1024];
+    for (;;) {
+      ssize_t n = ::read(fd, chunk, sizeof(chunk));
+      if (n > 0) {
+        buffer_.append(chunk, static_cast<std::size_t>(n));
+      } else if (n == 0 || errno != EINTR) {
+        ok_ = (n == 0);
+        break;
+      }
+    }
+    ::close(fd);
+    return ok_;
+  }
+
+  void close() noexcept {
+    if (map_) {
+      munmap(map_, map_size_);
+      map_ = nullptr;
+      map_size_ = 0;
+    }
+    buffer_.clear();
+    ok_ = false;
+  }
+
+  bool isOpen() const noexcept {
+    return ok_;
+  }
+
+  std::string_view view() const noexcept {
+    if (map_) {
+      return { static_cast<const char *>(map_), map_size_ };
+    }
+    return buffer_;
+  }
+
+  // Faults the pages in now, e.g. on a worker thread, so later reads don't block.
+  void prefetch() const noexcept {
+    if (!map_) {
+      return;
+    }
+    madvise(map_, map_size_, MADV_WILLNEED);
+    const long page = sysconf(_SC_PAGESIZE);
+    volatile char sink = 0;
+    for (std::size_t i = 0; i < map_size_; i += static_cast<std::size_t>(page)) {
+      sink = sink + static_cast<const char *>(map_)[i];
+    }
+  }
+
+ private:
+  void *map_ = nullptr;
+  std::size_t map_size_ = 0;
+  std::string buffer_;
+  bool ok_ = false;
+};
+
 // Check if a path exists and is a regular file
 inline bool fileExists(const std::filesystem::path &path) noexcept {
   std::error_code ec;
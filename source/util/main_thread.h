@@ -0,0 +1,93 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/**
+ * @file main_thread.h
+ * @brief Hands results from worker threads back to the main loop.
+ *
+ * post() is g_idle_add() for a std::function, callable from any thread.
+ * shutdown() drops the callbacks that have not run yet and refuses new ones,
+ * so no plugin code is called from the main loop after the plugin is
+ * unloaded.  Call it after the workers have stopped.
+ */
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+
+#include <glib.h>
+
+class MainThread final {
+ public:
+  static MainThread &instance() {
+    static MainThread inst;
+    return inst;
+  }
+
+ private:
+  MainThread() = default;
+  ~MainThread() = default;
+
+  MainThread(const MainThread &) = delete;
+  MainThread &operator=(const MainThread &) = delete;
+  MainThread(MainThread &&) = delete;
+  MainThread &operator=(MainThread &&) = delete;
+
+ public:
+  // Runs fn on the main thread when it is idle.  Returns false, without
+  // running fn, after shutdown().
+  bool post(std::function<void()> fn) {
+    auto *call = new Call{ std::move(fn) };
+
+    // Held until the id is recorded; dispatch() waits for it
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stopped_) {
+      delete call;
+      return false;
+    }
+    call->id = g_idle_add_full(G_PRIORITY_DEFAULT_IDLE, dispatch, call, destroy);
+    pending_.insert(call->id);
+    return true;
+  }
+
+  // Main thread
+  void shutdown() {
+    std::unordered_set<guint> pending;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopped_ = true;
+      pending.swap(pending_);
+    }
+    for (guint id : pending) {
+      g_source_remove(id);  // destroys the call and what it holds
+    }
+  }
+
+ private:
+  struct Call {
+    std::function<void()> fn;
+    guint id = 0;
+  };
+
+  static gboolean dispatch(gpointer data) {
+    auto *call = static_cast<Call *>(data);
+    auto &self = instance();
+    {
+      std::lock_guard<std::mutex> lock(self.mutex_);
+      self.pending_.erase(call->id);
+    }
+    call->fn();
+    return G_SOURCE_REMOVE;
+  }
+
+  static void destroy(gpointer data) {
+    delete static_cast<Call *>(data);
+  }
+
+  std::mutex mutex_;
+  std::unordered_set<guint> pending_;
+  bool stopped_ = false;
+};
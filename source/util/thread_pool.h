@@ -0,0 +1,158 @@
+// SPDX-FileCopyrightText: Copyright 2026 xiota
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+/**
+ * @file thread_pool.h
+ * @brief Small shared worker pool for CPU-bound background work.
+ *
+ * Workers are started on first use and joined by shutdown(), which the plugin
+ * calls on cleanup after cancelling running jobs.  parallelFor() lets the
+ * calling thread take part in the work, so it is safe to call from a task that
+ * is itself running on the pool.  A task that throws is abandoned; the worker
+ * carries on.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool final {
+ public:
+  static ThreadPool &instance() {
+    static ThreadPool inst;
+    return inst;
+  }
+
+ private:
+  ThreadPool() {
+    unsigned n = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    workers_.reserve(n);
+    for (unsigned i = 0; i < n; ++i) {
+      workers_.emplace_back([this] { workerLoop(); });
+    }
+  }
+
+  ~ThreadPool() {
+    shutdown();
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+  ThreadPool(ThreadPool &&) = delete;
+  ThreadPool &operator=(ThreadPool &&) = delete;
+
+ public:
+  // Number of threads available for parallelFor(), including the caller.
+  std::size_t concurrency() const noexcept {
+    return workers_.size() + 1;
+  }
+
+  // Drops queued tasks, waits for running ones and refuses new ones.  Tasks
+  // posted afterwards are discarded; parallelFor() runs on the caller alone.
+  void shutdown() {
+    std::deque<std::function<void()>> dropped;  // destroyed outside the lock
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stopping_ = true;
+      dropped.swap(tasks_);
+    }
+    cv_.notify_all();
+    for (auto &t : workers_) {
+      if (t.joinable() && t.get_id() != std::this_thread::get_id()) {
+        t.join();
+      }
+    }
+  }
+
+  void post(std::function<void()> task) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (stopping_) {
+        return;
+      }
+      tasks_.push_back(std::move(task));
+    }
+    cv_.notify_one();
+  }
+
+  // Runs fn(0) .. fn(count - 1) across the pool and the calling thread.
+  // Returns false if any invocation threw.
+  bool parallelFor(std::size_t count, std::function<void(std::size_t)> fn) {
+    struct State {
+      std::function<void(std::size_t)> fn;
+      std::size_t count = 0;
+      std::atomic<std::size_t> next{ 0 };
+      std::size_t done = 0;
+      bool failed = false;
+      std::mutex mutex;
+      std::condition_variable cv;
+    };
+
+    auto state = std::make_shared<State>();
+    state->fn = std::move(fn);
+    state->count = count;
+
+    // Helpers that start after all indices are claimed exit without touching fn.
+    auto drain = [](const std::shared_ptr<State> &s) {
+      for (std::size_t i; (i = s->next.fetch_add(1)) < s->count;) {
+        bool ok = true;
+        try {
+          s->fn(i);
+        } catch (...) {
+          ok = false;
+        }
+        std::lock_guard<std::mutex> lock(s->mutex);
+        s->failed = s->failed || !ok;
+        if (++s->done == s->count) {
+          s->cv.notify_all();
+        }
+      }
+    };
+
+    std::size_t helpers = std::min(count > 0 ? count - 1 : 0, workers_.size());
+    for (std::size_t i = 0; i < helpers; ++i) {
+      post([state, drain] { drain(state); });
+    }
+    drain(state);
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&] { return state->done == state->count; });
+    return !state->failed;
+  }
+
+ private:
+  void workerLoop() {
+    for (;;) {
+      std::function<void()> task;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+        if (stopping_) {
+          return;
+        }
+        task = std::move(tasks_.front());
+        tasks_.pop_front();
+      }
+      try {
+        task();
+      } catch (...) {
+        // An escaping exception would terminate the host application
+      }
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  std::vector<std::thread> workers_;
+  bool stopping_ = false;
+};
@@ -4,6 +4,9 @@
 #include "webview.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
 #include <string>
 #include <string_view>
 
@@ -15,6 +18,8 @@
 #include "preview_pane.h"
 #include "util/file_utils.h"
 #include "util/string_utils.h"
+#include "util/main_thread.h"
+#include "util/thread_pool.h"
 #include "webview_context_menu.h"
 #include "webview_find_dialog.h"
 
@@ -23,16 +28,14 @@ namespace {
 }  // namespace
 
 WebView::~WebView() {
+  destroyViews();
   if (G_IS_OBJECT(webview_settings_)) {
     g_object_unref(webview_settings_);
   }
 }
 
 void WebView::reset() {
-  if (GTK_IS_WIDGET(webview_)) {
-    gtk_widget_destroy(webview_);
-    webview_ = nullptr;
-  }
+  destroyViews();
   if (G_IS_OBJECT(webview_settings_)) {
     g_object_unref(webview_settings_);
     webview_settings_ = nullptr;
@@ -48,20 +51,25 @@ void WebView::reset() {
   // custom context with no disk cache directory
   webview_context_ = webkit_web_context_new_with_website_data_manager(manager);
 
-  webview_ = webkit_web_view_new_with_context(webview_context_);
-  webkit_web_view_set_settings(WEBKIT_WEB_VIEW(webview_), webview_settings_);
-
   // minimize caching (in‑memory only, no disk persistence)
   webkit_web_context_set_cache_model(webview_context_, WEBKIT_CACHE_MODEL_DOCUMENT_VIEWER);
 
+  webview_ = createView();
   webview_content_manager_ =
       webkit_web_view_get_user_content_manager(WEBKIT_WEB_VIEW(webview_));
+  pool_.push_back({ std::string{}, webview_ });
+}
+
+GtkWidget *WebView::createView() {
+  GtkWidget *view = webkit_web_view_new_with_context(webview_context_);
+  g_object_ref_sink(view);
+  webkit_web_view_set_settings(WEBKIT_WEB_VIEW(view), webview_settings_);
 
   // enable tooltip handling
-  gtk_widget_set_has_tooltip(GTK_WIDGET(webview_), true);
+  gtk_widget_set_has_tooltip(GTK_WIDGET(view), true);
 
   g_signal_connect(
-      webview_,
+      view,
       "query-tooltip",
       G_CALLBACK(
           +[](GtkWidget *, gint, gint, gboolean, GtkTooltip *tooltip, gpointer user_data) {
@@ -79,7 +87,7 @@ void WebView::reset() {
   );
 
   g_signal_connect(
-      webview_,
+      view,
       "mouse-target-changed",
       G_CALLBACK(+[](WebKitWebView *, WebKitHitTestResult *hit, guint, gpointer user_data) {
         auto *self = static_cast<WebView *>(user_data);
@@ -96,36 +104,121 @@ void WebView::reset() {
 
   // enable zoom handling
   auto &cfg = PreviewConfig::instance();
-  double zoom = cfg.get<int>("preview_zoom_default", 100);
-  zoom = std::max(zoom / 100.0, 0.01);
-  webkit_web_view_set_zoom_level(WEBKIT_WEB_VIEW(webview_), zoom);
+  double zoom = std::max(cfg.get(Settings::kPreviewZoomDefault), 0.01);
+  webkit_web_view_set_zoom_level(WEBKIT_WEB_VIEW(view), zoom);
 
   g_signal_connect(
-      webview_,
+      view,
       "load-changed",
       G_CALLBACK(+[](WebKitWebView *view, WebKitLoadEvent load_event, gpointer user_data) {
+        // Pooled views load on their own; patch the one that finished
         if (load_event == WEBKIT_LOAD_FINISHED) {
-          static_cast<WebView *>(user_data)->injectPatcher();
+          static_cast<WebView *>(user_data)->injectPatcher(view);
         }
       }),
       this
   );
 
   g_signal_connect(
-      webview_, "context-menu", G_CALLBACK(WebViewContextMenu::onContextMenu), nullptr
+      view, "context-menu", G_CALLBACK(WebViewContextMenu::onContextMenu), nullptr
   );
 
-  g_signal_connect(webview_, "decide-policy", G_CALLBACK(onDecidePolicy), nullptr);
-  g_signal_connect(webview_, "scroll-event", G_CALLBACK(onScrollEvent), nullptr);
+  g_signal_connect(view, "decide-policy", G_CALLBACK(onDecidePolicy), nullptr);
+  g_signal_connect(view, "scroll-event", G_CALLBACK(onScrollEvent), nullptr);
+
+  return view;
+}
+
+void WebView::destroyViews() {
+  for (auto &pooled : pool_) {
+    if (GTK_IS_WIDGET(pooled.widget)) {
+      gtk_widget_destroy(pooled.widget);
+    }
+    g_object_unref(pooled.widget);
+  }
+  pool_.clear();
+  webview_ = nullptr;
+  webview_content_manager_ = nullptr;
+}
+
+WebView::ViewSwitch WebView::switchTo(const std::string &key, std::size_t pool_size) {
+  auto it = std::find_if(pool_.begin(), pool_.end(), [&](const PooledView &v) {
+    return v.key == key;
+  });
+  if (it == pool_.begin() && it != pool_.end()) {
+    return ViewSwitch::Current;
+  }
+
+  PooledView next;
+  ViewSwitch result;
+  if (it != pool_.end()) {
+    next = std::move(*it);
+    pool_.erase(it);
+    result = ViewSwitch::Reused;
+  } else if (!pool_.empty() && pool_.size() >= std::max<std::size_t>(pool_size, 1)) {
+    next = std::move(pool_.back());
+    pool_.pop_back();
+    next.key = key;
+    result = ViewSwitch::Recycled;
+  } else {
+    next = { key, createView() };
+    result = ViewSwitch::Created;
+  }
+
+  GtkWidget *old = webview_;
+  pool_.insert(pool_.begin(), std::move(next));
+  webview_ = pool_.front().widget;
+  webview_content_manager_ =
+      webkit_web_view_get_user_content_manager(WEBKIT_WEB_VIEW(webview_));
+  hover_url_.clear();
+
+  // Take the old view's place; the pool keeps the old one alive
+  if (old && old != webview_) {
+    if (GtkWidget *parent = gtk_widget_get_parent(old)) {
+      gtk_container_remove(GTK_CONTAINER(parent), old);
+      if (GTK_IS_BOX(parent)) {
+        gtk_box_pack_start(GTK_BOX(parent), webview_, true, true, 0);
+      } else {
+        gtk_container_add(GTK_CONTAINER(parent), webview_);
+      }
+      gtk_widget_show(webview_);
+    }
+  }
+  return result;
+}
+
+void WebView::bindCurrent(const std::string &key) {
+  if (pool_.empty()) {
+    return;
+  }
+
+  // Another view showing the same document would never be current again
+  for (auto it = pool_.begin() + 1; it != pool_.end(); ++it) {
+    if (it->key == key) {
+      if (GTK_IS_WIDGET(it->widget)) {
+        gtk_widget_destroy(it->widget);
+      }
+      g_object_unref(it->widget);
+      pool_.erase(it);
+      break;
+    }
+  }
+  pool_.front().key = key;
+}
+
+bool WebView::hasView(const std::string &key) const {
+  return std::any_of(pool_.begin(), pool_.end(), [&](const PooledView &v) {
+    return v.key == key;
+  });
 }
 
 GtkWidget *WebView::widget() const {
   return webview_;
 }
 
-WebView &WebView::injectPatcher() {
+WebView &WebView::injectPatcher(WebKitWebView *view) {
   webkit_web_view_evaluate_javascript(
-      WEBKIT_WEB_VIEW(webview_),
+      view ? view : WEBKIT_WEB_VIEW(webview_),
       kApplyPatchJS.data(),
       kApplyPatchJS.size(),
       nullptr,
@@ -141,13 +234,16 @@ WebView &WebView::loadHtml(
     std::string_view body_content,
     const std::string &base_uri,
     std::string_view root_id,
-    double *scroll_fraction_ptr
+    double *scroll_fraction_ptr,
+    std::string_view sourcepos
 ) {
   double fraction = scroll_fraction_ptr ? *scroll_fraction_ptr : 0.0;
   fraction = std::clamp(fraction, 0.0, 1.0);
 
   std::string html;
-  html.reserve(256 + kApplyPatchJS.size() + body_content.size() + root_id.size());
+  html.reserve(
+      256 + kApplyPatchJS.size() + body_content.size() + root_id.size() + sourcepos.size()
+  );
 
   html.append(
       "<!DOCTYPE html><html><head>"
@@ -163,7 +259,13 @@ WebView &WebView::loadHtml(
   html.append(StringUtils::escapeHtml(root_id));
   html.append("\">");
   html.append(body_content);
-  html.append("</div></body></html>");
+  html.append("</div>");
+  if (!sourcepos.empty()) {
+    html.append("<script>setSourcepos(");
+    html.append(sourcepos);
+    html.append(");</script>");
+  }
+  html.append("</body></html>");
 
   webkit_web_view_load_html(WEBKIT_WEB_VIEW(webview_), html.c_str(), base_uri.c_str());
 
@@ -175,7 +277,8 @@ WebView &WebView::updateHtml(
     std::string_view body_content,
     const std::string &base_uri,
     std::string_view root_id,
-    double *scroll_fraction_ptr
+    double *scroll_fraction_ptr,
+    std::string_view sourcepos
 ) {
   double fraction = scroll_fraction_ptr ? *scroll_fraction_ptr : 0.0;
   fraction = std::clamp(fraction, 0.0, 1.0);
@@ -185,6 +288,9 @@ WebView &WebView::updateHtml(
   std::string js;
   js = "applyPatch(`" + escaped + "`, `" + escapeForJsTemplateLiteral(root_id) +
        "`);"
+       "setSourcepos(" +
+       std::string{ sourcepos.empty() ? std::string_view{ "null" } : sourcepos } +
+       ");"
        "window.scrollTo(0, document.body.scrollHeight * " +
        std::to_string(fraction) + ");";
 
@@ -359,6 +465,28 @@ WebView &WebView::showFindPrompt(GtkWindow *parent) {
   return *this;
 }
 
+namespace {
+// Linked files at least this large are mapped and paged in on a worker thread
+constexpr std::uintmax_t kAsyncLoadSize = 4 * 1024 * 1024;
+
+// Dropped if the pane has shown something else since, e.g. another document
+// or a later link
+void loadLocalAsync(std::string path) {
+  std::uint64_t navigation = PreviewPane::instance().startNavigation();
+  ThreadPool::instance().post([path = std::move(path), navigation]() {
+    auto contents = DocumentLocal::load(path, true);
+    MainThread::instance().post([path, contents, navigation] {
+      auto &pane = PreviewPane::instance();
+      if (pane.navigation() != navigation) {
+        return;
+      }
+      DocumentLocal doc(path, contents);
+      pane.initWebView(doc);
+    });
+  });
+}
+}  // namespace
+
 void WebView::onDecidePolicy(
     WebKitWebView *view,
     WebKitPolicyDecision *decision,
@@ -379,6 +507,18 @@ void WebView::onDecidePolicy(
         return;
       }
 
+      // "Render anyway" link from the large-file notice
+      constexpr std::string_view kForceRender = "geany-preview:force-render?";
+      if (std::string_view(uri).substr(0, kForceRender.size()) == kForceRender) {
+        gchar *file = g_uri_unescape_string(uri + kForceRender.size(), nullptr);
+        if (file) {
+          PreviewPane::instance().forceRender(file);
+          g_free(file);
+        }
+        webkit_policy_decision_ignore(decision);
+        return;
+      }
+
       const gchar *scheme = g_uri_parse_scheme(uri);
       if (scheme && g_str_equal(scheme, "file")) {
         gchar *filename = g_filename_from_uri(uri, nullptr, nullptr);
@@ -387,7 +527,13 @@ void WebView::onDecidePolicy(
 
           auto &pane = PreviewPane::instance();
           if (pane.canPreviewFile(doc)) {
-            pane.initWebView(doc);
+            std::error_code ec;
+            auto size = std::filesystem::file_size(filename, ec);
+            if (!ec && size >= kAsyncLoadSize) {
+              loadLocalAsync(filename);
+            } else {
+              pane.initWebView(doc);
+            }
             webkit_policy_decision_ignore(decision);
             g_free(filename);
             return;
@@ -413,7 +559,7 @@ void WebView::onDecidePolicy(
 
 gboolean WebView::onScrollEvent(GtkWidget *widget, GdkEventScroll *event, gpointer user_data) {
   auto &cfg = PreviewConfig::instance();
-  if (!cfg.get<bool>("disable_preview_ctrl_wheel_zoom", false)) {
+  if (!cfg.get(Settings::kDisablePreviewCtrlWheelZoom)) {
     return false;
   }
 
@@ -494,7 +640,7 @@ constexpr int SCINTILLA_MAX_OFFSET = 20;
 
 WebView &WebView::resetZoom() {
   auto &cfg = PreviewConfig::instance();
-  double zoom = cfg.get<double>("preview_zoom_default", 1.0);
+  double zoom = cfg.get(Settings::kPreviewZoomDefault);
   return setZoom(zoom);
 }
 
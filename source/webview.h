@@ -7,6 +7,7 @@
 #include <functional>
 #include <string>
 #include <string_view>
+#include <vector>
 
 #include <gtk/gtk.h>
 #include <webkit2/webkit2.h>
@@ -35,19 +36,45 @@ class WebView final {
   GtkWidget *widget() const;
   void reset();
 
-  WebView &injectPatcher();
+  // For views outside the pool, e.g. offscreen printing.  Replaced by reset().
+  WebKitWebContext *context() const {
+    return webview_context_;
+  }
+  WebKitSettings *settings() const {
+    return webview_settings_;
+  }
+
+  // Views kept alive for recently shown documents (webview_pool_size).  All
+  // share one web context; the current one is widget().
+  enum class ViewSwitch {
+    Current,   // key was already current
+    Reused,    // parked view for key, page intact
+    Recycled,  // least recently used view rebound to key; needs a full load
+    Created,   // new view; needs a full load and signal handlers
+  };
+
+  // Makes the view for key current and swaps it into the old view's parent.
+  ViewSwitch switchTo(const std::string &key, std::size_t pool_size);
+  // Rebinds the current view, e.g. after it was navigated to another file.
+  void bindCurrent(const std::string &key);
+  bool hasView(const std::string &key) const;
+
+  // Into view, or the current view if null
+  WebView &injectPatcher(WebKitWebView *view = nullptr);
   WebView &loadHtml(
       std::string_view body_content,
       const std::string &base_uri,
       std::string_view root_id,
-      double *scroll_fraction_ptr
+      double *scroll_fraction_ptr,
+      std::string_view sourcepos = {}
   );
 
   WebView &updateHtml(
       std::string_view body_content,
       const std::string &base_uri,
       std::string_view root_id,
-      double *scroll_fraction_ptr
+      double *scroll_fraction_ptr,
+      std::string_view sourcepos = {}
   );
   void getScrollFraction(std::function<void(double)> callback) const;
   WebView &setScrollFraction(double fraction);
@@ -98,6 +125,15 @@ class WebView final {
 
   static gboolean onScrollEvent(GtkWidget *widget, GdkEventScroll *event, gpointer user_data);
 
+  GtkWidget *createView();
+  void destroyViews();
+
+  struct PooledView {
+    std::string key;
+    GtkWidget *widget = nullptr;  // owned reference
+  };
+  std::vector<PooledView> pool_;  // most recently used first
+
   WebKitSettings *webview_settings_ = nullptr;
   GtkWidget *webview_ = nullptr;
   WebKitWebContext *webview_context_ = nullptr;